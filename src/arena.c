@@ -0,0 +1,127 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+
+#define ARENA_ALIGN (0x10)
+
+struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size;
+	size_t used;
+	size_t reserved; // keep data ARENA_ALIGN aligned
+};
+
+static ArenaBlock *arena_new_block(size_t size){
+
+	ArenaBlock *block;
+
+	block = malloc(sizeof(*block) + size);
+	if(block == NULL){
+		return NULL;
+	}
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+int arena_init(Arena *pArena, size_t block_size){
+
+	if(block_size == 0){
+		block_size = 0x40000;
+	}
+
+	pArena->head       = NULL;
+	pArena->current    = NULL;
+	pArena->block_size = block_size;
+
+	return 0;
+}
+
+int arena_fini(Arena *pArena){
+
+	ArenaBlock *block = pArena->head, *next;
+
+	while(block != NULL){
+		next = block->next;
+		free(block);
+		block = next;
+	}
+
+	pArena->head    = NULL;
+	pArena->current = NULL;
+
+	return 0;
+}
+
+int arena_reset(Arena *pArena){
+
+	ArenaBlock *block = pArena->head;
+
+	while(block != NULL){
+		block->used = 0;
+		block = block->next;
+	}
+
+	pArena->current = pArena->head;
+
+	return 0;
+}
+
+void *arena_alloc(Arena *pArena, size_t size){
+
+	ArenaBlock *block = pArena->current;
+
+	size = (size + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+
+	// Skip over kept blocks until one has room for this allocation
+	while(block != NULL && (block->size - block->used) < size){
+		if(block->next == NULL){
+			break;
+		}
+
+		block = block->next;
+	}
+
+	if(block == NULL || (block->size - block->used) < size){
+		ArenaBlock *new_block = arena_new_block((size > pArena->block_size) ? size : pArena->block_size);
+		if(new_block == NULL){
+			printf("%s: cannot alloc 0x%zX bytes\n", __FUNCTION__, size);
+			return NULL;
+		}
+
+		if(block == NULL){
+			pArena->head = new_block;
+		}else{
+			new_block->next = block->next;
+			block->next = new_block;
+		}
+
+		block = new_block;
+	}
+
+	pArena->current = block;
+
+	void *ptr = (char *)&(block[1]) + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+char *arena_strndup(Arena *pArena, const char *str, size_t len){
+
+	char *new_str = arena_alloc(pArena, len + 1);
+	if(new_str == NULL){
+		return NULL;
+	}
+
+	memcpy(new_str, str, len);
+	new_str[len] = 0;
+
+	return new_str;
+}
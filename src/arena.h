@@ -0,0 +1,38 @@
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+	ArenaBlock *head;
+	ArenaBlock *current;
+	size_t block_size;
+} Arena;
+
+int arena_init(Arena *pArena, size_t block_size);
+int arena_fini(Arena *pArena);
+
+/*
+ * Drops every allocation at once. The blocks are kept and reused by
+ * following arena_alloc calls.
+ */
+int arena_reset(Arena *pArena);
+
+void *arena_alloc(Arena *pArena, size_t size);
+char *arena_strndup(Arena *pArena, const char *str, size_t len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ARENA_H_ */
@@ -0,0 +1,109 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "file_map.h"
+
+
+static int file_map_read_all(int fd, FileMap *pMap){
+
+	ssize_t res;
+	size_t size = 0, capacity = 0x10000;
+	char *data, *new_data;
+
+	data = malloc(capacity);
+	if(data == NULL){
+		return -1;
+	}
+
+	while(1){
+		if(size == capacity){
+			capacity *= 2;
+
+			new_data = realloc(data, capacity);
+			if(new_data == NULL){
+				free(data);
+				return -1;
+			}
+
+			data = new_data;
+		}
+
+		res = read(fd, &(data[size]), capacity - size);
+		if(res < 0){
+			if(errno == EINTR){
+				continue;
+			}
+
+			free(data);
+			return -1;
+		}
+
+		if(res == 0){
+			break;
+		}
+
+		size += (size_t)res;
+	}
+
+	pMap->data      = data;
+	pMap->size      = size;
+	pMap->is_mapped = 0;
+
+	return 0;
+}
+
+int file_map_open(const char *path, FileMap *pMap){
+
+	int fd, res;
+	struct stat stat_info;
+
+	memset(pMap, 0, sizeof(*pMap));
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0){
+		return -1;
+	}
+
+	res = -1;
+
+	if(fstat(fd, &stat_info) == 0 && S_ISREG(stat_info.st_mode) && stat_info.st_size > 0){
+		void *data = mmap(NULL, (size_t)stat_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data != MAP_FAILED){
+			madvise(data, (size_t)stat_info.st_size, MADV_WILLNEED);
+
+			pMap->data      = data;
+			pMap->size      = (size_t)stat_info.st_size;
+			pMap->is_mapped = 1;
+			res = 0;
+		}
+	}
+
+	if(res < 0){
+		res = file_map_read_all(fd, pMap);
+	}
+
+	close(fd);
+
+	return res;
+}
+
+int file_map_close(FileMap *pMap){
+
+	if(pMap->data != NULL){
+		if(pMap->is_mapped != 0){
+			munmap(pMap->data, pMap->size);
+		}else{
+			free(pMap->data);
+		}
+	}
+
+	memset(pMap, 0, sizeof(*pMap));
+
+	return 0;
+}
@@ -0,0 +1,31 @@
+
+#ifndef _FILE_MAP_H_
+#define _FILE_MAP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+
+typedef struct FileMap {
+	void *data;
+	size_t size;
+	int is_mapped; // 0: data is heap memory read with read()
+} FileMap;
+
+/*
+ * Regular files are mapped read-only. Anything that cannot be mapped
+ * (pipes, character devices, ...) is read into heap memory instead.
+ */
+int file_map_open(const char *path, FileMap *pMap);
+int file_map_close(FileMap *pMap);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FILE_MAP_H_ */
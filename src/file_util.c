@@ -0,0 +1,185 @@
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "file_util.h"
+
+
+int create_parent_directory(const char *path){
+
+	int res;
+	int path_len = strlen(path);
+	char *new_path = malloc(path_len + 1);
+	if(new_path == NULL){
+		return -1;
+	}
+
+	new_path[path_len] = 0;
+	memcpy(new_path, path, path_len);
+
+	char *x, *v = new_path;
+
+	res = 0;
+
+	// Usually the directory is there already: one stat instead of one per component
+	x = strrchr(new_path, '/');
+	if(x != NULL && x != new_path){
+		struct stat stat_info;
+
+		*x = 0;
+
+		if(stat(new_path, &stat_info) == 0 && S_ISDIR(stat_info.st_mode)){
+			free(new_path);
+			return 0;
+		}
+
+		*x = '/';
+	}
+
+	while((x = strchr(v, '/')) != NULL){
+
+		*x = 0;
+
+		struct stat stat_info;
+		if(stat(new_path, &stat_info) != 0){
+			res = mkdir(new_path, 0777);
+			if(res < 0 && errno == EEXIST){ // Created by another payload worker
+				res = 0;
+			}
+
+			if(res < 0){
+				printf("failed mkdir 0x%X for \"%s\"\n", res, new_path);
+				break;
+			}
+			// printf("mkdir %s\n", v);
+		}
+
+		*x = '/';
+
+		v = &(x[1]);
+	}
+
+	free(new_path);
+	new_path = NULL;
+
+	return res;
+}
+
+FILE *create_output_file(const char *path){
+
+	int fd;
+	FILE *fp;
+
+	if(unlink(path) < 0 && errno != ENOENT){
+		return NULL;
+	}
+
+	fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+	if(fd < 0){
+		return NULL;
+	}
+
+	fp = fdopen(fd, "wb");
+	if(fp == NULL){
+		close(fd);
+		return NULL;
+	}
+
+	return fp;
+}
+
+int create_file_with_recursive(const char *path, const void *data, int size){
+
+	int res;
+	const char *name;
+
+	res = create_parent_directory(path);
+	if(res < 0){
+		return res;
+	}
+
+	name = strrchr(path, '/');
+	name = (name != NULL) ? &(name[1]) : path;
+
+	if(strlen(name) != 0){
+		// printf("create %s\n", name);
+
+		FILE *fp;
+		fp = create_output_file(path);
+		if(fp == NULL){
+			return -1;
+		}
+
+		fwrite(data, 1, (size_t)size, fp);
+		fclose(fp);
+		fp = NULL;
+	}
+
+	return 0;
+}
+
+static int copy_file(const char *src, const char *dst){
+
+	int res, fd_src, fd_dst;
+	ssize_t n;
+	char *buffer;
+
+	fd_src = open(src, O_RDONLY);
+	if(fd_src < 0){
+		return -1;
+	}
+
+	fd_dst = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if(fd_dst < 0){
+		close(fd_src);
+		return -1;
+	}
+
+	buffer = malloc(0x40000);
+	if(buffer == NULL){
+		close(fd_dst);
+		close(fd_src);
+		return -1;
+	}
+
+	res = 0;
+
+	while((n = read(fd_src, buffer, 0x40000)) > 0){
+		if(write(fd_dst, buffer, n) != n){
+			res = -1;
+			break;
+		}
+	}
+
+	if(n < 0){
+		res = -1;
+	}
+
+	free(buffer);
+	close(fd_dst);
+	close(fd_src);
+
+	return res;
+}
+
+int link_or_copy_file(const char *src, const char *dst){
+
+	int res;
+
+	res = create_parent_directory(dst);
+	if(res < 0){
+		return res;
+	}
+
+	unlink(dst);
+
+	if(link(src, dst) == 0){
+		return 0;
+	}
+
+	return copy_file(src, dst);
+}
@@ -0,0 +1,34 @@
+
+#ifndef _FILE_UTIL_H_
+#define _FILE_UTIL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdio.h>
+
+
+int create_parent_directory(const char *path);
+
+/*
+ * Opens path as a new, empty file. An existing file is unlinked rather than
+ * truncated, because it may be a hardlink (a duplicate payload or a cache
+ * entry) whose other names have to keep their contents.
+ */
+FILE *create_output_file(const char *path);
+int create_file_with_recursive(const char *path, const void *data, int size);
+
+/*
+ * Makes dst a hardlink of src, replacing dst if it exists. Falls back to a
+ * copy when the two are on different filesystems or links are unsupported.
+ */
+int link_or_copy_file(const char *src, const char *dst);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FILE_UTIL_H_ */
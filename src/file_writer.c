@@ -0,0 +1,491 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "file_util.h"
+#include "file_writer.h"
+
+#if defined(RCO_USE_IO_URING)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+
+#define FILE_WRITER_DEPTH_DEFAULT (0x40)
+
+#if defined(RCO_USE_IO_URING)
+
+/*
+ * The raw interface of <linux/io_uring.h>, so there is nothing to link
+ * against. Only one thread uses a ring, and only for a batch at a time.
+ */
+struct FileWriterRing {
+	int fd;
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	unsigned int *sq_tail;
+	unsigned int sq_local_tail; // Entries up to here are filled but not yet published
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+static void file_writer_ring_destroy(FileWriterRing *ring){
+
+	if(ring->sqes != NULL && ring->sqes != MAP_FAILED){
+		munmap(ring->sqes, ring->sqes_size);
+	}
+
+	if(ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr){
+		munmap(ring->cq_ptr, ring->cq_size);
+	}
+
+	if(ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED){
+		munmap(ring->sq_ptr, ring->sq_size);
+	}
+
+	if(ring->fd >= 0){
+		close(ring->fd);
+	}
+
+	free(ring);
+}
+
+// unlinkat needs 5.11, older kernels take the synchronous path
+static int file_writer_ring_probe(FileWriterRing *ring){
+
+	int res;
+	struct io_uring_probe *probe;
+	const int ops[] = {IORING_OP_UNLINKAT, IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_CLOSE};
+
+	probe = calloc(1, sizeof(*probe) + sizeof(struct io_uring_probe_op) * 0x100);
+	if(probe == NULL){
+		return -1;
+	}
+
+	res = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 0x100);
+
+	for(int i=0;res >= 0 && i<(int)(sizeof(ops) / sizeof(ops[0]));i++){
+		if(ops[i] > probe->last_op || (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED) == 0){
+			res = -1;
+		}
+	}
+
+	free(probe);
+
+	return (res < 0) ? -1 : 0;
+}
+
+static int file_writer_ring_create(FileWriterRing **ppRing, int nEntry){
+
+	FileWriterRing *ring;
+	struct io_uring_params params;
+
+	*ppRing = NULL;
+
+	ring = calloc(1, sizeof(*ring));
+	if(ring == NULL){
+		return -1;
+	}
+
+	memset(&params, 0, sizeof(params));
+
+	ring->fd = syscall(__NR_io_uring_setup, nEntry, &params);
+	if(ring->fd < 0){
+		free(ring);
+		return -1;
+	}
+
+	ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if((params.features & IORING_FEAT_SINGLE_MMAP) != 0){
+		if(ring->cq_size > ring->sq_size){
+			ring->sq_size = ring->cq_size;
+		}
+
+		ring->cq_size = ring->sq_size;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if(ring->sq_ptr == MAP_FAILED){
+		file_writer_ring_destroy(ring);
+		return -1;
+	}
+
+	if((params.features & IORING_FEAT_SINGLE_MMAP) != 0){
+		ring->cq_ptr = ring->sq_ptr;
+	}else{
+		ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+		if(ring->cq_ptr == MAP_FAILED){
+			file_writer_ring_destroy(ring);
+			return -1;
+		}
+	}
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if(ring->sqes == MAP_FAILED){
+		file_writer_ring_destroy(ring);
+		return -1;
+	}
+
+	ring->sq_tail  = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.tail);
+	ring->sq_mask  = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.array);
+	ring->cq_head  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.head);
+	ring->cq_tail  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.tail);
+	ring->cq_mask  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.ring_mask);
+	ring->cqes     = (struct io_uring_cqe *)((char *)ring->cq_ptr + params.cq_off.cqes);
+
+	ring->sq_local_tail = *ring->sq_tail;
+
+	if(file_writer_ring_probe(ring) < 0){
+		file_writer_ring_destroy(ring);
+		return -1;
+	}
+
+	*ppRing = ring;
+
+	return 0;
+}
+
+// The caller never queues more than the ring holds
+static struct io_uring_sqe *file_writer_ring_get_sqe(FileWriterRing *ring){
+
+	unsigned int index = ring->sq_local_tail++ & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &(ring->sqes[index]);
+
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_array[index] = index;
+
+	return sqe;
+}
+
+/*
+ * Submits nSubmit entries and hands each of the nComplete completions to
+ * callback. Interrupted waits are resumed.
+ */
+static int file_writer_ring_run(FileWriterRing *ring, unsigned int nSubmit, unsigned int nComplete, void (* callback)(FileWriter *pWriter, const struct io_uring_cqe *cqe), FileWriter *pWriter){
+
+	int res;
+
+	// Publishes the filled entries, the release store orders them before the tail
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	while(nComplete != 0){
+		unsigned int head = *ring->cq_head;
+		unsigned int tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+		while(head != tail && nComplete != 0){
+			callback(pWriter, &(ring->cqes[head & *ring->cq_mask]));
+			head++;
+			nComplete--;
+		}
+
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+		if(nComplete == 0){
+			break;
+		}
+
+		res = syscall(__NR_io_uring_enter, ring->fd, nSubmit, nComplete, IORING_ENTER_GETEVENTS, NULL, 0);
+		if(res < 0){
+			if(errno == EINTR || errno == EAGAIN || errno == EBUSY){
+				continue;
+			}
+
+			return -1;
+		}
+
+		nSubmit -= ((unsigned int)res < nSubmit) ? (unsigned int)res : nSubmit;
+	}
+
+	return 0;
+}
+
+// user_data is the entry index times two, plus one for the open. The unlink may fail, usually with ENOENT
+static void file_writer_on_open(FileWriter *pWriter, const struct io_uring_cqe *cqe){
+
+	if((cqe->user_data & 1) != 0){
+		pWriter->entries[cqe->user_data >> 1].fd = cqe->res;
+	}
+}
+
+// user_data is the entry index times two, plus one for the close
+static void file_writer_on_write(FileWriter *pWriter, const struct io_uring_cqe *cqe){
+
+	FileWriterEntry *entry = &(pWriter->entries[cqe->user_data >> 1]);
+
+	if((cqe->user_data & 1) != 0){
+		// -ECANCELED after a short or failed write, closed synchronously then
+		entry->is_closed = (cqe->res >= 0);
+	}else if(cqe->res > 0){
+		entry->written = cqe->res;
+	}
+}
+
+// What io_uring left undone: the rest of a short write and its close
+static int file_writer_finish_entry(FileWriterEntry *entry){
+
+	int res = 0;
+
+	while(entry->written < entry->size){
+		ssize_t n = pwrite(entry->fd, (const char *)entry->data + entry->written, entry->size - entry->written, entry->written);
+		if(n <= 0){
+			if(n < 0 && errno == EINTR){
+				continue;
+			}
+
+			res = -1;
+			break;
+		}
+
+		entry->written += n;
+	}
+
+	if(entry->is_closed == 0){
+		if(close(entry->fd) < 0){
+			res = -1;
+		}
+
+		entry->is_closed = 1;
+	}
+
+	return res;
+}
+
+static int file_writer_flush_ring(FileWriter *pWriter){
+
+	int res = 0;
+	unsigned int nSubmit = 0;
+	FileWriterRing *ring = pWriter->ring;
+
+	/*
+	 * An existing file may be a hardlink (a duplicate payload or a cache
+	 * entry), so it is replaced instead of truncated. The hard link runs the
+	 * open whether or not there was anything to unlink.
+	 */
+	for(int i=0;i<pWriter->nEntry;i++){
+		FileWriterEntry *entry = &(pWriter->entries[i]);
+		struct io_uring_sqe *sqe;
+
+		sqe = file_writer_ring_get_sqe(ring);
+		sqe->opcode     = IORING_OP_UNLINKAT;
+		sqe->flags      = IOSQE_IO_HARDLINK;
+		sqe->fd         = AT_FDCWD;
+		sqe->addr       = (uintptr_t)entry->path;
+		sqe->user_data  = (uint64_t)i << 1;
+
+		sqe = file_writer_ring_get_sqe(ring);
+		sqe->opcode     = IORING_OP_OPENAT;
+		sqe->fd         = AT_FDCWD;
+		sqe->addr       = (uintptr_t)entry->path;
+		sqe->open_flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+		sqe->len        = 0666;
+		sqe->user_data  = ((uint64_t)i << 1) | 1;
+	}
+
+	if(file_writer_ring_run(ring, pWriter->nEntry * 2, pWriter->nEntry * 2, file_writer_on_open, pWriter) < 0){
+		for(int i=0;i<pWriter->nEntry;i++){
+			if(pWriter->entries[i].fd >= 0){
+				close(pWriter->entries[i].fd);
+			}
+		}
+
+		printf("io_uring submission failed\n");
+		return -1;
+	}
+
+	for(int i=0;i<pWriter->nEntry;i++){
+		FileWriterEntry *entry = &(pWriter->entries[i]);
+		struct io_uring_sqe *sqe;
+
+		if(entry->fd < 0){
+			continue;
+		}
+
+		if(entry->size != 0){
+			sqe = file_writer_ring_get_sqe(ring);
+			sqe->opcode    = IORING_OP_WRITE;
+			sqe->flags     = IOSQE_IO_LINK;
+			sqe->fd        = entry->fd;
+			sqe->addr      = (uintptr_t)entry->data;
+			sqe->len       = entry->size;
+			sqe->off       = 0;
+			sqe->user_data = (uint64_t)i << 1;
+			nSubmit++;
+		}
+
+		sqe = file_writer_ring_get_sqe(ring);
+		sqe->opcode    = IORING_OP_CLOSE;
+		sqe->fd        = entry->fd;
+		sqe->user_data = ((uint64_t)i << 1) | 1;
+		nSubmit++;
+	}
+
+	if(nSubmit != 0 && file_writer_ring_run(ring, nSubmit, nSubmit, file_writer_on_write, pWriter) < 0){
+		printf("io_uring submission failed\n");
+		return -1;
+	}
+
+	for(int i=0;i<pWriter->nEntry;i++){
+		FileWriterEntry *entry = &(pWriter->entries[i]);
+
+		if(entry->fd < 0 || file_writer_finish_entry(entry) < 0){
+			printf("cannot write \"%s\"\n", entry->path);
+			res = -1;
+			continue;
+		}
+
+		rco_stats_add_count(pWriter->stats, RCO_STATS_FILES_WRITTEN, 1);
+		rco_stats_add_count(pWriter->stats, RCO_STATS_PAYLOAD_BYTES_OUT, entry->size);
+	}
+
+	return res;
+}
+
+#endif
+
+// Only the first file in a directory creates or checks it
+static int file_writer_create_parent(FileWriter *pWriter, const char *path){
+
+	int res;
+	const char *name = strrchr(path, '/');
+	size_t len = (name != NULL) ? (size_t)(name - path) : 0;
+
+	if(len == pWriter->last_dir_len && pWriter->last_dir != NULL && memcmp(pWriter->last_dir, path, len) == 0){
+		return 0;
+	}
+
+	res = create_parent_directory(path);
+	if(res < 0){
+		return res;
+	}
+
+	char *last_dir = realloc(pWriter->last_dir, len + 1);
+	if(last_dir == NULL){
+		return 0;
+	}
+
+	memcpy(last_dir, path, len);
+	last_dir[len] = 0;
+
+	pWriter->last_dir     = last_dir;
+	pWriter->last_dir_len = len;
+
+	return 0;
+}
+
+int file_writer_init(FileWriter *pWriter, int nDepth, RcoStats *pStats){
+
+	memset(pWriter, 0, sizeof(*pWriter));
+
+	pWriter->stats = pStats;
+
+#if defined(RCO_USE_IO_URING)
+	if(nDepth <= 0){
+		nDepth = FILE_WRITER_DEPTH_DEFAULT;
+	}
+
+	pWriter->entries = malloc(sizeof(*pWriter->entries) * nDepth);
+	if(pWriter->entries == NULL){
+		return -1;
+	}
+
+	// An unlink and an open, or a write and a close per file
+	if(file_writer_ring_create(&(pWriter->ring), nDepth * 2) < 0){
+		free(pWriter->entries);
+		pWriter->entries = NULL;
+		return -1;
+	}
+
+	pWriter->nEntryMax = nDepth;
+
+	return 0;
+#else
+	(void)nDepth;
+
+	return -1;
+#endif
+}
+
+int file_writer_fini(FileWriter *pWriter){
+
+	int res;
+
+	res = file_writer_flush(pWriter);
+
+#if defined(RCO_USE_IO_URING)
+	if(pWriter->ring != NULL){
+		file_writer_ring_destroy(pWriter->ring);
+		pWriter->ring = NULL;
+	}
+#endif
+
+	free(pWriter->entries);
+	pWriter->entries = NULL;
+
+	free(pWriter->last_dir);
+	pWriter->last_dir = NULL;
+
+	return res;
+}
+
+int file_writer_add(FileWriter *pWriter, const char *path, const void *data, size_t size){
+
+	int res;
+	FileWriterEntry *entry;
+
+	res = file_writer_create_parent(pWriter, path);
+	if(res < 0){
+		return res;
+	}
+
+	entry = &(pWriter->entries[pWriter->nEntry++]);
+
+	entry->path      = path;
+	entry->data      = data;
+	entry->size      = size;
+	entry->written   = 0;
+	entry->fd        = -1;
+	entry->is_closed = 0;
+
+	if(pWriter->nEntry == pWriter->nEntryMax){
+		return file_writer_flush(pWriter);
+	}
+
+	return 0;
+}
+
+int file_writer_flush(FileWriter *pWriter){
+
+	int res = 0;
+
+	if(pWriter->nEntry == 0){
+		return 0;
+	}
+
+#if defined(RCO_USE_IO_URING)
+	uint64_t start = rco_stats_start(pWriter->stats);
+
+	res = file_writer_flush_ring(pWriter);
+
+	rco_stats_add_time(pWriter->stats, RCO_STATS_TIME_WRITE, start);
+#endif
+
+	pWriter->nEntry = 0;
+
+	return res;
+}
@@ -0,0 +1,61 @@
+#ifndef _FILE_WRITER_H_
+#define _FILE_WRITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include "rco_stats.h"
+
+
+typedef struct FileWriterRing FileWriterRing;
+
+typedef struct FileWriterEntry {
+	const char *path;
+	const void *data;
+	size_t size;
+	size_t written;
+	int fd;
+	int is_closed;
+} FileWriterEntry;
+
+/*
+ * Writes whole files in batches through io_uring: one submission replaces
+ * (unlinks and creates) every file of the batch, a second one writes and
+ * closes them all. Existing files are never rewritten in place. The parent
+ * directory of the previous file is remembered, so files that go to the same
+ * directory do not stat it again.
+ */
+typedef struct FileWriter {
+	FileWriterRing *ring;
+	FileWriterEntry *entries;
+	int nEntry;
+	int nEntryMax;
+	char *last_dir; // Known to exist
+	size_t last_dir_len;
+	RcoStats *stats; // Flush time, and the files and bytes written once they are
+} FileWriter;
+
+/*
+ * Returns < 0 if io_uring is not available (not built with RCO_USE_IO_URING,
+ * or refused by the kernel), in which case callers write synchronously.
+ * nDepth is the number of files per batch, 0 for the default. pStats may be NULL.
+ */
+int file_writer_init(FileWriter *pWriter, int nDepth, RcoStats *pStats);
+int file_writer_fini(FileWriter *pWriter); // Flushes what is left
+
+/*
+ * Queues a file. path and data are not copied and have to stay valid until
+ * the next flush, which happens here when the batch is full.
+ */
+int file_writer_add(FileWriter *pWriter, const char *path, const void *data, size_t size);
+int file_writer_flush(FileWriter *pWriter);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FILE_WRITER_H_ */
@@ -0,0 +1,164 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hash_table.h"
+
+
+#define HASH_PRIME_1 (0x9E3779B185EBCA87ULL)
+#define HASH_PRIME_2 (0xC2B2AE3D27D4EB4FULL)
+
+static inline uint64_t hash_rotl(uint64_t x, int r){
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_read64(const unsigned char *p){
+
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+uint64_t hash_table_hash_u64(uint64_t value){
+
+	value ^= value >> 33;
+	value *= HASH_PRIME_2;
+	value ^= value >> 29;
+	value *= HASH_PRIME_1;
+	value ^= value >> 32;
+
+	return value;
+}
+
+uint64_t hash_table_hash_bytes(const void *data, size_t size, uint64_t seed){
+
+	const unsigned char *p = (const unsigned char *)data;
+	uint64_t h[4] = {
+		seed + HASH_PRIME_1 + HASH_PRIME_2,
+		seed + HASH_PRIME_2,
+		seed,
+		seed - HASH_PRIME_1
+	};
+	size_t n = size;
+
+	// Four independent lanes keep the multiplies pipelined on large inputs
+	while(n >= 32){
+		for(int i=0;i<4;i++){
+			h[i] = hash_rotl(h[i] + hash_read64(&p[i * 8]) * HASH_PRIME_2, 31) * HASH_PRIME_1;
+		}
+
+		p += 32;
+		n -= 32;
+	}
+
+	uint64_t v = hash_rotl(h[0], 1) + hash_rotl(h[1], 7) + hash_rotl(h[2], 12) + hash_rotl(h[3], 18);
+
+	v += (uint64_t)size;
+
+	while(n >= 8){
+		v = hash_rotl(v ^ (hash_read64(p) * HASH_PRIME_2), 27) * HASH_PRIME_1;
+		p += 8;
+		n -= 8;
+	}
+
+	while(n != 0){
+		v = hash_rotl(v ^ (*p * HASH_PRIME_1), 11) * HASH_PRIME_2;
+		p += 1;
+		n -= 1;
+	}
+
+	return hash_table_hash_u64(v);
+}
+
+int hash_table_init(HashTable *pTable, size_t capacity){
+
+	size_t n = 0x10;
+
+	while(n < capacity * 2){
+		n <<= 1;
+	}
+
+	pTable->entries = calloc(n, sizeof(HashTableEntry));
+	if(pTable->entries == NULL){
+		return -1;
+	}
+
+	pTable->capacity = n;
+	pTable->count    = 0;
+
+	return 0;
+}
+
+int hash_table_fini(HashTable *pTable){
+
+	free(pTable->entries);
+	pTable->entries  = NULL;
+	pTable->capacity = 0;
+	pTable->count    = 0;
+
+	return 0;
+}
+
+static void hash_table_place(HashTableEntry *entries, size_t capacity, uint64_t hash, void *value){
+
+	size_t i = (size_t)hash & (capacity - 1);
+
+	while(entries[i].hash != 0){
+		i = (i + 1) & (capacity - 1);
+	}
+
+	entries[i].hash  = hash;
+	entries[i].value = value;
+}
+
+int hash_table_insert(HashTable *pTable, uint64_t hash, void *value){
+
+	if(hash == 0){
+		hash = 1;
+	}
+
+	// Keep the load factor under 1/2
+	if((pTable->count + 1) * 2 > pTable->capacity){
+		size_t capacity = pTable->capacity * 2;
+		HashTableEntry *entries = calloc(capacity, sizeof(HashTableEntry));
+		if(entries == NULL){
+			return -1;
+		}
+
+		for(size_t i=0;i<pTable->capacity;i++){
+			if(pTable->entries[i].hash != 0){
+				hash_table_place(entries, capacity, pTable->entries[i].hash, pTable->entries[i].value);
+			}
+		}
+
+		free(pTable->entries);
+		pTable->entries  = entries;
+		pTable->capacity = capacity;
+	}
+
+	hash_table_place(pTable->entries, pTable->capacity, hash, value);
+	pTable->count += 1;
+
+	return 0;
+}
+
+void *hash_table_find(const HashTable *pTable, uint64_t hash, int (* match)(const void *value, const void *key), const void *key){
+
+	if(hash == 0){
+		hash = 1;
+	}
+
+	size_t i = (size_t)hash & (pTable->capacity - 1);
+
+	while(pTable->entries[i].hash != 0){
+		if(pTable->entries[i].hash == hash && (match == NULL || match(pTable->entries[i].value, key) != 0)){
+			return pTable->entries[i].value;
+		}
+
+		i = (i + 1) & (pTable->capacity - 1);
+	}
+
+	return NULL;
+}
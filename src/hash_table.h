@@ -0,0 +1,43 @@
+
+#ifndef _HASH_TABLE_H_
+#define _HASH_TABLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef struct HashTableEntry {
+	uint64_t hash; // 0 marks an empty slot
+	void *value;
+} HashTableEntry;
+
+/*
+ * Open addressing table from a 64-bit hash to a value. Several values may
+ * share a hash; hash_table_find asks match() to pick the right one.
+ */
+typedef struct HashTable {
+	HashTableEntry *entries;
+	size_t capacity;
+	size_t count;
+} HashTable;
+
+int hash_table_init(HashTable *pTable, size_t capacity);
+int hash_table_fini(HashTable *pTable);
+
+int hash_table_insert(HashTable *pTable, uint64_t hash, void *value);
+void *hash_table_find(const HashTable *pTable, uint64_t hash, int (* match)(const void *value, const void *key), const void *key);
+
+uint64_t hash_table_hash_bytes(const void *data, size_t size, uint64_t seed);
+uint64_t hash_table_hash_u64(uint64_t value);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HASH_TABLE_H_ */
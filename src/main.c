@@ -1,1096 +1,502 @@
-
-
 #include <sys/stat.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdint.h>
 #include <string.h>
-#include <wchar.h>
-#include <math.h>
-#include <zlib.h>
+#include <strings.h>
+#include <unistd.h>
 #include "fs_list.h"
-
-
-typedef int32_t SceInt32;
-typedef uint32_t SceUInt32;
-typedef unsigned short SceWChar16;
-
-
-typedef struct SceRcoHeader { // size is 0x50-bytes
-	char magic[4]; // CXML
-	SceInt32 version;  // 0x110
-	SceInt32 tree_offset;
-	SceInt32 tree_size;
-
-	SceInt32 idtable_offset;
-	SceInt32 idtable_size;
-	SceInt32 idhashtable_offset;
-	SceInt32 idhashtable_size;
-
-	// 0x20
-	SceInt32 stringtable_offset;
-	SceInt32 stringtable_size;
-	SceInt32 wstringtable_offset;
-	SceInt32 wstringtable_size;
-
-	SceInt32 hashtable_offset;
-	SceInt32 hashtable_size;
-	SceInt32 intarraytable_offset;
-	SceInt32 intarraytable_size;
-	SceInt32 floatarraytable_offset;
-	SceInt32 floatarraytable_size;
-	SceInt32 filetable_offset;
-	SceInt32 filetable_size;
-} SceRcoHeader;
-
-typedef struct SceRcoTreeHeader { // size is 0x1C-bytes
-	SceInt32 name_handle;
-	SceInt32 num_attributes;
-	SceInt32 parent_elm_offset;
-	SceInt32 prev_elm_offset;
-	SceInt32 next_elm_offset;
-	SceInt32 first_child_elm_offset;
-	SceInt32 last_child_elm_offset;
-} SceRcoTreeHeader;
-
-#define attr_type_int        1
-#define attr_type_float      2
-#define attr_type_string     3
-#define attr_type_wstring    4
-#define attr_type_hash       5
-#define attr_type_intarray   6
-#define attr_type_floatarray 7
-#define attr_type_filename   8
-#define attr_type_id         9
-#define attr_type_idref      10
-#define attr_type_idhash     11
-#define attr_type_idhashref  12
-
-
-typedef struct CXmlTag CXmlTag;
-
-typedef struct CXmlKeyValue {
-	struct CXmlKeyValue *next;
-	CXmlTag *tag;
-	char *key;
-
-	int type;
-	union {
-		struct {
-			int data;
-		} type_int;
-		struct {
-			float data;
-		} type_float;
-		struct {
-			char *data;
-		} type_string;
-		struct {
-			SceWChar16 *data;
-		} type_wstring;
-		struct {
-			SceUInt32 data;
-		} type_hash;
-		struct {
-			SceInt32 *data;
-			int size;
-		} type_intarray;
-		struct {
-			float *data;
-			int size;
-		} type_floatarray;
-		struct {
-			char *output;
-			void *data;
-			int size;
-		} type_filename;
-		struct {
-			char *data;
-		} type_id;
-		struct {
-			int unk; // TODO
-		} type_idref;
-		struct {
-			SceUInt32 data;
-		} type_idhash;
-		struct {
-			SceUInt32 data;
-		} type_idhashref;
-	};
-} CXmlKeyValue;
-
-typedef struct CXmlTag {
-	struct CXmlTag *parent;
-	struct CXmlTag *child;
-	struct CXmlTag *next;
-	char *name;
-	CXmlKeyValue *kv;
-} CXmlTag;
-
-
-int create_file_with_recursive(const char *path, const void *data, int size){
-
+#include "arena.h"
+#include "hash_table.h"
+#include "thread_pool.h"
+#include "rco_decompiler.h"
+#include "rco_compiler.h"
+#include "rco_diff.h"
+#include "rco_grep.h"
+
+
+typedef struct BatchJob {
+	char *path;
+	long size;
 	int res;
-	int path_len = strlen(path);
-	char *new_path = malloc(path_len + 1);
-	new_path[path_len] = 0;
-	memcpy(new_path, path, path_len);
-
-	char *x, *v = new_path;
-
-	res = 0;
-
-	do {
-		x = strchr(v, '/');
-		if(x != NULL){
+	const RcoDecompilerOption *opt;
+	Arena **arenas;
+	ThreadPool *pool; // for the payloads of this job
+} BatchJob;
 
-			*x = 0;
+typedef struct BatchList {
+	BatchJob *jobs;
+	int nJob;
+	int nMax;
+} BatchList;
 
-			struct stat stat_info;
-			if(stat(new_path, &stat_info) != 0){
-				res = mkdir(new_path, 0777);
-				if(res < 0){
-					printf("failed mkdir 0x%X for \"%s\"\n", res, new_path);
-					break;
-				}
-				// printf("mkdir %s\n", v);
-			}
-
-			*x = '/';
+int batch_list_add(BatchList *pList, const char *path){
 
-			v = &(x[1]);
-		}else if(strlen(v) != 0){
-			// printf("create %s\n", v);
+	struct stat stat_info;
 
-			FILE *fp;
-			fp = fopen(path, "wb");
-			if(fp == NULL){
-				res = -1;
-				break;
-			}
-
-			fwrite(data, 1, (size_t)size, fp);
-			fclose(fp);
-			fp = NULL;
-		}
-	} while(x != NULL);
-
-	free(new_path);
-	new_path = NULL;
-
-	return res;
-}
-
-const char *rco_dec_get_string(const void *rco_data, int attr){
-
-	const SceRcoHeader *pHeader;
-
-	pHeader = (const SceRcoHeader *)rco_data;
-
-	return (const char *)(rco_data + pHeader->stringtable_offset + attr);
-}
-
-const SceWChar16 *rco_dec_get_wstring(const void *rco_data, int attr){
-
-	const SceRcoHeader *pHeader;
-
-	pHeader = (const SceRcoHeader *)rco_data;
-
-	return (const SceWChar16 *)(rco_data + pHeader->wstringtable_offset + (attr << 1));
-}
-
-int unicode2utf8(FILE *fp, SceWChar16 unicode){
-
-	if(unicode < 0x80){
+	if(stat(path, &stat_info) != 0){
+		printf("cannot stat \"%s\"\n", path);
+		return -1;
+	}
 
-		if(unicode == '\n'){
-			fprintf(fp, "&#xA;");
-		}else{
-			fprintf(fp, "%c", unicode);
+	if(pList->nJob == pList->nMax){
+		int nMax = (pList->nMax == 0) ? 0x40 : pList->nMax * 2;
+		BatchJob *jobs = realloc(pList->jobs, sizeof(*jobs) * nMax);
+		if(jobs == NULL){
+			return -1;
 		}
 
-	}else if(unicode < 0x800){
-		fprintf(fp, "%c", 0xC0 | ((unicode >> 6) & 0x1F));
-		fprintf(fp, "%c", 0x80 | (unicode & 0x3F));
-	}else{
-		fprintf(fp, "%c", 0xE0 | ((unicode >> 12) & 0xF));
-		fprintf(fp, "%c", 0x80 | ((unicode & 0xFC0) >> 6));
-		fprintf(fp, "%c", 0x80 | (unicode & 0x3F));
+		pList->jobs = jobs;
+		pList->nMax = nMax;
 	}
 
-	return 0;
-}
-
-int sce_paf_wcslen(const SceWChar16 *wstr){
-
-	const SceWChar16 *s = wstr;
-
-	while(*wstr != 0){
-		wstr++;
+	int path_len = strlen(path);
+	char *new_path = malloc(path_len + 1);
+	if(new_path == NULL){
+		return -1;
 	}
 
-	return wstr - s;
-}
+	new_path[path_len] = 0;
+	memcpy(new_path, path, path_len);
 
-int sce_paf_fwprint(FILE *fp, const SceWChar16 *wstr){
+	BatchJob *job = &(pList->jobs[pList->nJob]);
 
-	while(*wstr != 0){
-		unicode2utf8(fp, *wstr);
-		wstr++;
-	}
+	job->path  = new_path;
+	job->size  = (long)stat_info.st_size;
+	job->res   = 0;
+	job->opt   = NULL;
+
+	pList->nJob += 1;
 
 	return 0;
 }
 
-int search_tag_key_by_name(CXmlTag *cxml, const char *name, CXmlKeyValue **result){
-
-	CXmlKeyValue *kv = cxml->kv;
-
-	while(kv != NULL){
-		if(strcmp(kv->key, name) == 0){
-			*result = kv;
-			return 0;
-		}
+int batch_list_callback(FSListEntry *ent, void *argp){
 
-		kv = kv->next;
+	if(ent->isDir != 0 || ent->name == NULL){
+		return 0;
 	}
 
-	return -1;
-}
-
-int search_tag_child_by_name(CXmlTag *cxml, const char *name, CXmlTag **result){
-
-	CXmlTag *child = cxml->child;
-
-	while(child != NULL){
-		if(strcmp(child->name, name) == 0){
-			*result = child;
-			return 0;
-		}
-
-		child = child->next;
+	const char *ext = strrchr(ent->name, '.');
+	if(ext == NULL || strcasecmp(ext, ".rco") != 0){
+		return 0;
 	}
 
-	return -1;
+	return batch_list_add((BatchList *)argp, ent->path_full);
 }
 
-int parse_element_tags(const void *rco_data, const void *element, CXmlTag *tag, CXmlKeyValue **result){
-
-	const SceRcoHeader *pHeader = (const SceRcoHeader *)(rco_data);
-	const SceRcoTreeHeader *element_header = (const SceRcoTreeHeader *)(element);
+int batch_list_add_path(BatchList *pList, const char *path){
 
-	CXmlKeyValue *head, *tail;
+	int res;
+	struct stat stat_info;
 
-	head = malloc(sizeof(*head));
-	if(head == NULL){
-		printf("%s: cannot alloc head\n", __FUNCTION__);
+	if(stat(path, &stat_info) != 0){
+		printf("cannot stat \"%s\"\n", path);
 		return -1;
 	}
 
-	memset(head, 0, sizeof(*head));
-	head->next = NULL;
-	head->tag  = NULL;
-	head->key  = NULL;
-
-	*result = head;
-	tail = head;
-
-	for(int i=0;i<element_header->num_attributes;i++){
-
-		void *base = (void *)(element + sizeof(SceRcoTreeHeader) + 0x10 * i);
-
-		int attrname_handle = *(SceInt32 *)(base + 0);
-		int attr_type = *(SceInt32 *)(base + 4);
+	if(S_ISDIR(stat_info.st_mode)){
+		FSListEntry *ent = NULL;
 
-		head = malloc(sizeof(*head));
-		if(head == NULL){
-			printf("%s: cannot alloc head\n", __FUNCTION__);
-			return -1;
+		res = fs_list_init(path, &ent, NULL, NULL);
+		if(res < 0){
+			printf("cannot open directory \"%s\"\n", path);
+			return res;
 		}
 
-		memset(head, 0, sizeof(*head));
-		head->next = NULL;
-		head->tag  = tag;
-		head->key  = NULL;
-
-		tail->next = head;
-		tail = head;
-
-		// init key
-		{
-			const char *key = rco_dec_get_string(rco_data, attrname_handle);
-			int key_len =  strlen(key);
+		res = fs_list_execute(ent->child, batch_list_callback, pList);
+		fs_list_fini(ent);
 
-			char *new_key = malloc(key_len + 1);
-			if(new_key == NULL){
-				printf("%s: cannot alloc new_key\n", __FUNCTION__);
-				return -1;
-			}
+		return res;
+	}
 
-			new_key[key_len] = 0;
-			memcpy(new_key, key, key_len);
-			head->key = new_key;
-		}
+	return batch_list_add(pList, path);
+}
 
-		head->type = attr_type;
+int batch_job_compare(const void *a, const void *b){
 
-		switch(attr_type){
-		case attr_type_int:
-			head->type_int.data = *(SceInt32 *)(base + 8);
-			break;
-		case attr_type_float:
-			head->type_float.data = *(float *)(base + 8);
-			break;
-		case attr_type_string:
-			{
-				const char *str = rco_dec_get_string(rco_data, *(SceInt32 *)(base + 8));
-				int str_len = strlen(str);
-				char *new_str = malloc(str_len + 1);
-				if(new_str == NULL){
-					printf("%s: cannot alloc new_str\n", __FUNCTION__);
-					return -1;
-				}
-
-				new_str[str_len] = 0;
-				memcpy(new_str, str, str_len);
-
-				head->type_string.data = new_str;
-			}
-			break;
-		case attr_type_wstring:
-			{
-				const SceWChar16 *wstr = rco_dec_get_wstring(rco_data, *(SceInt32 *)(base + 8));
-				int wstr_len = sce_paf_wcslen(wstr);
-				SceWChar16 *new_wstr = malloc((wstr_len + 1) * 2);
-				if(new_wstr == NULL){
-					printf("%s: cannot alloc new_wstr\n", __FUNCTION__);
-					return -1;
-				}
-
-				new_wstr[wstr_len] = 0;
-				memcpy(new_wstr, wstr, wstr_len * 2);
-
-				head->type_wstring.data = new_wstr;
-			}
-			break;
-		case attr_type_hash:
-			if(*(SceInt32 *)(base + 0xC) != 4){
-				exit(1);
-			}
+	const BatchJob *job_a = (const BatchJob *)a;
+	const BatchJob *job_b = (const BatchJob *)b;
 
-			{
-				SceUInt32 *hashtable = (SceUInt32 *)(rco_data + pHeader->hashtable_offset);
-				head->type_hash.data = hashtable[*(SceInt32 *)(base + 8)];
-			}
-			break;
-		case attr_type_intarray:
-			{
-				SceInt32 *intarraytable = (SceInt32 *)(rco_data + pHeader->intarraytable_offset);
-				int offset = *(SceInt32 *)(base + 8);
-				int size = *(SceInt32 *)(base + 0xC);
-
-				SceInt32 *new_intarray = malloc(sizeof(SceInt32) * size);
-				if(new_intarray == NULL){
-					printf("%s: cannot alloc head\n", __FUNCTION__);
-					return -1;
-				}
-
-				memcpy(new_intarray, &(intarraytable[offset]), sizeof(SceInt32) * size);
-
-				head->type_intarray.data = new_intarray;
-				head->type_intarray.size = size;
-			}
-			break;
-		case attr_type_floatarray:
-			// printf(" %s=\"0x%X, 0x%X\"", rco_dec_get_string(rco_data, attrname_handle), *(SceInt32 *)(base + 8), *(SceInt32 *)(base + 0xC));
+	// Largest inputs first so the long jobs do not end up last on one worker
+	if(job_a->size != job_b->size){
+		return (job_a->size < job_b->size) ? 1 : -1;
+	}
 
-			{
-				float *floatarraytable = (float *)(rco_data + pHeader->floatarraytable_offset);
-				int offset = *(SceInt32 *)(base + 8);
-				int size = *(SceInt32 *)(base + 0xC);
+	return strcmp(job_a->path, job_b->path);
+}
 
-				float *new_floatarray = malloc(sizeof(float) * size);
-				if(new_floatarray == NULL){
-					printf("%s: cannot alloc head\n", __FUNCTION__);
-					return -1;
-				}
+int batch_job_entry(void *argp){
 
-				memcpy(new_floatarray, &(floatarraytable[offset]), sizeof(float) * size);
+	BatchJob *job = (BatchJob *)argp;
 
-				head->type_floatarray.data = new_floatarray;
-				head->type_floatarray.size = size;
-			}
+	// Each worker keeps its arena blocks for the next file
+	job->res = RcoDecompiler(job->path, job->opt, job->arenas[thread_pool_get_worker_index()], job->pool);
 
-			break;
-		case attr_type_filename:
-			{
-				const void *filetable = (const void *)(rco_data + pHeader->filetable_offset);
-				int offset = *(SceInt32 *)(base + 8);
-				int size = *(SceInt32 *)(base + 0xC);
-
-				void *new_file = malloc(size);
-				if(new_file == NULL){
-					printf("%s: cannot alloc head\n", __FUNCTION__);
-					return -1;
-				}
-
-				memcpy(new_file, filetable + offset, size);
-
-				head->type_filename.data = new_file;
-				head->type_filename.size = size;
-			}
-			break;
-		case attr_type_id:
-			{
-				const char *id = (const char *)(rco_data + pHeader->idtable_offset + *(SceInt32 *)(base + 8) + 4);
-				int id_len = strlen(id);
-				char *new_id = malloc(id_len + 1);
-				if(new_id == NULL){
-					printf("%s: cannot alloc head\n", __FUNCTION__);
-					return -1;
-				}
-
-				new_id[id_len] = 0;
-				memcpy(new_id, id, id_len);
-
-				head->type_id.data = new_id;
-			}
-			break;
-		case attr_type_idref:
-			// printf(" %s=\"0x%X\"", rco_dec_get_string(rco_data, attrname_handle), *(SceInt32 *)(base + 8));
-			break;
-		case attr_type_idhash:
-			head->type_idhash.data = *(SceUInt32 *)(rco_data + pHeader->idhashtable_offset + *(SceInt32 *)(base + 8) + 4);
-			break;
-		case attr_type_idhashref:
-			head->type_idhashref.data = *(SceUInt32 *)(rco_data + pHeader->idhashtable_offset + *(SceInt32 *)(base + 8) + 4);
-			break;
-		default:
-			break;
-		}
+	if(job->res < 0){
+		printf("[FAIL] %s (0x%X)\n", job->path, job->res);
+	}else{
+		printf("[ OK ] %s\n", job->path);
 	}
 
-	head = *result;
+	return job->res;
+}
 
-	*result = head->next;
-	free(head);
-	head = NULL;
+typedef struct BatchOutput {
+	char *name;
+	const char *path;
+} BatchOutput;
 
-	return 0;
+int batch_output_match(const void *value, const void *key){
+	return strcmp(((const BatchOutput *)value)->name, ((const BatchOutput *)key)->name) == 0;
 }
 
-int parse_element(const void *rco_data, const void *element, CXmlTag *parent, CXmlTag **result){
+/*
+ * Every input is written to ./<name>/ with no regard to its directory, so two
+ * inputs with the same name would be decompiled into one directory at once.
+ */
+int batch_list_check_outputs(BatchList *pList){
 
-	int res;
-	const SceRcoHeader *pHeader = (const SceRcoHeader *)(rco_data);
-	const SceRcoTreeHeader *element_header = (const SceRcoTreeHeader *)(element);
-	CXmlTag *cxml;
+	int res = 0;
+	HashTable table;
+	BatchOutput *outputs;
 
-	cxml = malloc(sizeof(*cxml));
-	if(cxml == NULL){
+	outputs = calloc(pList->nJob, sizeof(*outputs));
+	if(outputs == NULL){
 		return -1;
 	}
 
-	*result = cxml;
-
-	memset(cxml, 0, sizeof(*cxml));
-	cxml->parent = parent;
-	cxml->child  = NULL;
-	cxml->next   = NULL;
-	cxml->name   = NULL;
-	cxml->kv     = NULL;
-
-	const char *name = rco_dec_get_string(rco_data, element_header->name_handle);
-	int name_len = strlen(name);
-
-	char *new_name = malloc(name_len + 1);
-	if(new_name == NULL){
+	if(hash_table_init(&table, pList->nJob) < 0){
+		free(outputs);
 		return -1;
 	}
 
-	new_name[name_len] = 0;
-	memcpy(new_name, name, name_len);
-
-	cxml->name = new_name;
+	for(int i=0;i<pList->nJob;i++){
+		BatchOutput *output = &(outputs[i]);
 
-	if(element_header->first_child_elm_offset == -1 && element_header->last_child_elm_offset == -1){
-
-		res = parse_element_tags(rco_data, element, cxml, &(cxml->kv));
-		if(res < 0){
-			return res;
+		output->path = pList->jobs[i].path;
+		output->name = rco_dec_make_plugin_name(output->path);
+		if(output->name == NULL){
+			res = -1;
+			break;
 		}
 
-	}else if(element_header->first_child_elm_offset != -1){
+		uint64_t hash = hash_table_hash_bytes(output->name, strlen(output->name), 0);
 
-		res = parse_element_tags(rco_data, element, cxml, &(cxml->kv));
-		if(res < 0){
-			return res;
+		const BatchOutput *other = hash_table_find(&table, hash, batch_output_match, output);
+		if(other != NULL){
+			printf("\"%s\" and \"%s\" would both be written to ./%s/\n", other->path, output->path, output->name);
+			res = -1;
+			continue;
 		}
 
-		res = parse_element(rco_data, rco_data + pHeader->tree_offset + element_header->first_child_elm_offset, cxml, &(cxml->child));
-		if(res < 0){
-			return res;
+		if(hash_table_insert(&table, hash, output) < 0){
+			res = -1;
+			break;
 		}
 	}
 
-	if(element_header->next_elm_offset != -1){
-		res = parse_element(rco_data, rco_data + pHeader->tree_offset + element_header->next_elm_offset, cxml->parent, &(cxml->next));
-		if(res < 0){
-			return res;
-		}
+	for(int i=0;i<pList->nJob;i++){
+		free(outputs[i].name);
 	}
 
-	return 0;
-}
-
-int print_cxml_tags(const char *output_path, FILE *xml_fp, CXmlKeyValue *kv){
-
-	int res;
-
-	while(kv != NULL){
-
-		fprintf(xml_fp, " %s=\"", kv->key);
-
-		switch(kv->type){
-		case attr_type_int:
-			fprintf(xml_fp, "%d", kv->type_int.data);
-			break;
-		case attr_type_float:
-			{
-				float tmp;
-				if(modff(kv->type_float.data, &tmp) == 0.0f){
-					// printf("%.0f", kv->type_float.data);
-				}else{
-					// printf("%f", kv->type_float.data);
-				}
-
-				fprintf(xml_fp, "%g", kv->type_float.data);
-			}
+	hash_table_fini(&table);
+	free(outputs);
 
-			break;
-		case attr_type_string:
-			fprintf(xml_fp, "%s", kv->type_string.data);
-			break;
-		case attr_type_wstring:
-			sce_paf_fwprint(xml_fp, kv->type_wstring.data);
-			break;
-		case attr_type_hash:
-			fprintf(xml_fp, "0x%08X", kv->type_hash.data);
-			break;
-		case attr_type_intarray:
-			{
-				if(kv->type_intarray.size != 0){
-					fprintf(xml_fp, "%d", kv->type_intarray.data[0]);
-					for(int i=1;i<kv->type_intarray.size;i++){
-						fprintf(xml_fp, ", %d", kv->type_intarray.data[i]);
-					}
-				}
-			}
-			break;
-		case attr_type_floatarray:
-			{
-				if(kv->type_floatarray.size != 0){
-					float tmp;
-					if(modff(kv->type_floatarray.data[0], &tmp) == 0.0f){
-						// printf("%.0f", kv->type_floatarray.data[0]);
-					}else{
-						// printf("%f", kv->type_floatarray.data[0]);
-					}
-
-					fprintf(xml_fp, "%g", kv->type_floatarray.data[0]);
-
-					for(int i=1;i<kv->type_floatarray.size;i++){
-						if(modff(kv->type_floatarray.data[i], &tmp) == 0.0f){
-							// printf(", %.0f", kv->type_floatarray.data[i]);
-						}else{
-							// printf(", %f", kv->type_floatarray.data[i]);
-						}
-
-						fprintf(xml_fp, ", %g", kv->type_floatarray.data[i]);
-					}
-				}
-			}
-
-			break;
-		case attr_type_filename:
-			{
-				char src_path[0x80];
-				CXmlTag *tag = kv->tag;
-
-				if(strcmp(tag->name, "locale") == 0){
-					CXmlKeyValue *kv_id;
-					search_tag_key_by_name(tag, "id", &kv_id);
-					snprintf(src_path, sizeof(src_path), "%s/locale/plugin_locale_%s.xml.rcs", output_path, kv_id->type_id.data);
-				}else if(strcmp(tag->name, "texture") == 0 || strcmp(tag->name, "file") == 0 || strcmp(tag->name, "sounddata") == 0){
-					CXmlKeyValue *kv_id, *kv_type;
-					search_tag_key_by_name(tag, "id", &kv_id);
-					search_tag_key_by_name(tag, "type", &kv_type);
-
-					const char *type = kv_type->type_string.data;
-
-					const char *part = strchr(type, '/');
-					if(part != NULL){
-						char *new_name = malloc((part - type) + 1);
-						if(new_name == NULL){
-							return -1;
-						}
-
-						new_name[part - type] = 0;
-						memcpy(new_name, type, part - type);
-						snprintf(src_path, sizeof(src_path), "%s/%s/%s_0x%08X.%s", output_path, tag->name, new_name, kv_id->type_int.data, &(part[1]));
-						free(new_name);
-						new_name = NULL;
-					}else{
-						snprintf(src_path, sizeof(src_path), "%s/%s/%s_0x%08X.tex", output_path, tag->name, tag->name, kv_id->type_int.data);
-					}
-
-				}else{
-					src_path[0] = 0;
-				}
-
-				CXmlKeyValue *kv_compress = NULL;
-				search_tag_key_by_name(tag, "compress", &kv_compress);
-
-				if(kv_compress != NULL && strcmp(kv_compress->type_string.data, "on") == 0){
-
-					CXmlKeyValue *kv_origsize = NULL;
-					search_tag_key_by_name(tag, "origsize", &kv_origsize);
-
-					long unsigned int temp_size = kv_origsize->type_int.data;
-					void *temp_memory_ptr = malloc(temp_size);
-					if(temp_memory_ptr == NULL){
-						return -1;
-					}
-
-					int res = uncompress(temp_memory_ptr, &temp_size, kv->type_filename.data, kv->type_filename.size);
-					if(res != Z_OK){
-						printf("zlib uncompress failed : 0x%X\n", res);
-						res = -1;
-					}else{
-						res = create_file_with_recursive(src_path, temp_memory_ptr, kv_origsize->type_int.data);
-					}
-
-					free(temp_memory_ptr);
-					temp_memory_ptr = NULL;
-
-					if(res < 0){
-						return res;
-					}
-				}else{
-					res = create_file_with_recursive(src_path, kv->type_filename.data, kv->type_filename.size);
-					if(res < 0){
-						return res;
-					}
-				}
-
-				int src_len = strlen(src_path);
-				char *new_src = malloc(src_len + 1);
-				if(new_src == NULL){
-					return -1;
-				}
-
-				new_src[src_len] = 0;
-				memcpy(new_src, src_path, src_len);
-
-				kv->type_filename.output = new_src;
-
-				fprintf(xml_fp, "%s", new_src + strlen(output_path) + 1);
-			}
-			break;
-		case attr_type_id:
-			fprintf(xml_fp, "%s", kv->type_id.data);
-			break;
-		case attr_type_idref:
-			// TODO
-			break;
-		case attr_type_idhash:
-			fprintf(xml_fp, "0x%08X", kv->type_idhash.data);
-			break;
-		case attr_type_idhashref:
-			fprintf(xml_fp, "0x%08X", kv->type_idhashref.data);
-			break;
-		default:
-			break;
-		}
-
-		fprintf(xml_fp, "\"");
-
-		kv = kv->next;
-	}
-
-	return 0;
+	return res;
 }
 
-int print_cxml(const char *output_path, FILE *xml_fp, CXmlTag *cxml, int level){
+int RcoDecompiler_batch(BatchList *pList, int nThread, const RcoDecompilerOption *opt){
 
-	int res;
+	int res, nFailed, nArena;
+	ThreadPool *pPool = NULL;
+	Arena **arenas;
 
-	char *tab_data = malloc(level * 2 + 1);
-	if(tab_data == NULL){
+	if(batch_list_check_outputs(pList) < 0){
 		return -1;
 	}
 
-	tab_data[level * 2] = 0;
-	memset(tab_data, ' ', level * 2);
-
-	if(cxml->child == NULL){
+	qsort(pList->jobs, pList->nJob, sizeof(BatchJob), batch_job_compare);
 
-		fprintf(xml_fp, "%s<%s", tab_data, cxml->name);
-		res = print_cxml_tags(output_path, xml_fp, cxml->kv);
+	if(nThread != 1){
+		res = thread_pool_create(&pPool, nThread);
 		if(res < 0){
-			return res;
+			printf("cannot create thread pool, fallback to serial\n");
+			pPool = NULL;
 		}
+	}
 
-		fprintf(xml_fp, " />\n");
-
-	}else if(cxml->child != NULL){
+	nArena = thread_pool_get_thread_count(pPool);
 
-		fprintf(xml_fp, "%s<%s", tab_data, cxml->name);
-		res = print_cxml_tags(output_path, xml_fp, cxml->kv);
-		if(res < 0){
-			return res;
-		}
+	arenas = malloc(sizeof(*arenas) * nArena);
+	if(arenas == NULL){
+		thread_pool_destroy(pPool);
+		return -1;
+	}
 
-		fprintf(xml_fp, ">\n");
+	for(int i=0;i<nArena;i++){
+		arenas[i] = malloc(sizeof(Arena));
+		if(arenas[i] == NULL){
+			while(i > 0){
+				i--;
+				arena_fini(arenas[i]);
+				free(arenas[i]);
+			}
 
-		res = print_cxml(output_path, xml_fp, cxml->child, level + 1);
-		if(res < 0){
-			return res;
+			free(arenas);
+			thread_pool_destroy(pPool);
+			return -1;
 		}
 
-		fprintf(xml_fp, "%s</%s>\n", tab_data, cxml->name);
+		arena_init(arenas[i], 0);
 	}
 
-	free(tab_data);
-	tab_data = NULL;
-
-	if(cxml->next != NULL){
-		res = print_cxml(output_path, xml_fp, cxml->next, level);
-		if(res < 0){
-			return res;
+	if(pList->nJob == 1){
+		// Nothing to spread over the pool, give it to the payloads instead
+		pList->jobs[0].opt    = opt;
+		pList->jobs[0].arenas = arenas;
+		pList->jobs[0].pool   = pPool;
+		batch_job_entry(&(pList->jobs[0]));
+	}else{
+		for(int i=0;i<pList->nJob;i++){
+			pList->jobs[i].opt    = opt;
+			pList->jobs[i].arenas = arenas;
+			pList->jobs[i].pool   = NULL;
+			thread_pool_submit(pPool, batch_job_entry, &(pList->jobs[i]));
 		}
 	}
 
-	return 0;
-}
+	thread_pool_wait(pPool);
+	thread_pool_destroy(pPool);
+	pPool = NULL;
 
-int free_cxml_tags(CXmlKeyValue *kv){
-
-	CXmlKeyValue *kv_next;
-
-	while(kv != NULL){
-
-		kv_next = kv->next;
-
-		switch(kv->type){
-		case attr_type_int:
-			break;
-		case attr_type_float:
-			break;
-		case attr_type_string:
-			free(kv->type_string.data);
-			break;
-		case attr_type_wstring:
-			free(kv->type_wstring.data);
-			break;
-		case attr_type_hash:
-			break;
-		case attr_type_intarray:
-			free(kv->type_intarray.data);
-			break;
-		case attr_type_floatarray:
-			free(kv->type_floatarray.data);
-			break;
-		case attr_type_filename:
-			free(kv->type_filename.output);
-			free(kv->type_filename.data);
-			break;
-		case attr_type_id:
-			free(kv->type_id.data);
-			break;
-		case attr_type_idref:
-			// TODO
-			break;
-		case attr_type_idhash:
-			break;
-		case attr_type_idhashref:
-			break;
-		default:
-			break;
-		}
-
-		free(kv->key);
-		free(kv);
-
-		kv = kv_next;
+	for(int i=0;i<nArena;i++){
+		arena_fini(arenas[i]);
+		free(arenas[i]);
 	}
 
-	return 0;
-}
+	free(arenas);
 
-int free_cxml(CXmlTag *cxml){
-
-	if(cxml->child == NULL){
-		free_cxml_tags(cxml->kv);
-	}else if(cxml->child != NULL){
-		free_cxml_tags(cxml->kv);
-		free_cxml(cxml->child);
-	}
-
-	if(cxml->next != NULL){
-		free_cxml(cxml->next);
+	nFailed = 0;
+	for(int i=0;i<pList->nJob;i++){
+		if(pList->jobs[i].res < 0){
+			nFailed++;
+		}
 	}
 
-	free(cxml);
+	printf("%d succeeded, %d failed\n", pList->nJob - nFailed, nFailed);
 
-	return 0;
+	return (nFailed != 0) ? -1 : 0;
 }
 
-int RcsDecompiler_core(const char *xml_name, const void *rcs_data, int rcs_size){
-
-	int res;
-	const SceRcoHeader *pHeader;
-	CXmlTag *result;
-	FILE *xml_fp;
+/*
+ * Takes stdout over for the stats, and points everything else printed to it
+ * (status lines, the summary and diagnostics) at stderr, so the stream holds
+ * nothing but the JSON lines.
+ */
+FILE *stats_open_stdout(void){
 
-	pHeader = (const SceRcoHeader *)rcs_data;
+	int fd;
+	FILE *fp;
 
-	if(memcmp(pHeader->magic, "RCSF", 4) != 0){
-		printf("Header bad magic (%02X %02X %02X %02X)\n", pHeader->magic[0], pHeader->magic[1], pHeader->magic[2], pHeader->magic[3]);
-		return -1;
-	}
+	fflush(stdout);
 
-	xml_fp = fopen(xml_name, "wb");
-	if(xml_fp == NULL){
-		return -1;
+	fd = dup(STDOUT_FILENO);
+	if(fd < 0){
+		return NULL;
 	}
 
-	fprintf(xml_fp, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
-	// fprintf(xml_fp, "<?xml version=\"1.0\" encoding=\"unicode\"?>\n");
-
-	res = parse_element(rcs_data, (const void *)(rcs_data + pHeader->tree_offset), NULL, &result);
-	if(res >= 0){
-		res = print_cxml("NULL", xml_fp, result, 0);
+	if(dup2(STDERR_FILENO, STDOUT_FILENO) < 0){
+		close(fd);
+		return NULL;
 	}
-	free_cxml(result);
-	result = NULL;
-
-	fclose(xml_fp);
-	xml_fp = NULL;
-
-	return res;
-}
 
-int RcsDecompiler(const char *xml_name, const char *path, int flags){
-
-	int res;
-	long length;
-	char *rcs_data = NULL;
-
-	FILE *fp;
-	fp = fopen(path, "rb");
+	fp = fdopen(fd, "w");
 	if(fp == NULL){
-		return -1;
+		close(fd);
 	}
 
-	do {
-		fseek(fp, 0, SEEK_END);
-		length = ftell(fp);
-
-		rcs_data = malloc(length);
-		if(rcs_data == NULL){
-			res = -1;
-			break;
-		}
-
-		fseek(fp, 0, SEEK_SET);
-		fread(rcs_data, 1, (size_t)length, fp);
-
-		fclose(fp);
-		fp = NULL;
-
-		res = RcsDecompiler_core(xml_name, rcs_data, length);
-
-		free(rcs_data);
-		rcs_data = NULL;
-	} while(0);
-
-	return res;
+	return fp;
 }
 
-int process_stringtable(CXmlTag *root){
-
-	CXmlTag *cxml_stringtable_tag = NULL;
-
-	search_tag_child_by_name(root, "stringtable", &cxml_stringtable_tag);
-
-	if(cxml_stringtable_tag != NULL){
-		printf("Found %s in %s\n", cxml_stringtable_tag->name, cxml_stringtable_tag->parent->name);
-
-		CXmlTag *locale_link = cxml_stringtable_tag->child;
-		while(locale_link != NULL){
-			// printf("%s\n", locale_link->name);
+void usage(const char *argv0){
+	printf("usage: %s [options] <file.rco|directory>...\n", argv0);
+	printf("       %s [-j <n>] --compile <plugin.xml> <output.rco|output.rcs>\n", argv0);
+	printf("       %s [options] --extract <id|0xHASH> <file.rco>...\n", argv0);
+	printf("       %s --diff <old.rco> <new.rco>\n", argv0);
+	printf("       %s [-j <n>] --grep <text|0xHASH> <file.rco|directory>...\n", argv0);
+	printf("  -j <n>      number of worker threads (default: cpu count)\n");
+	printf("  --no-rcs    do not write the locale .rcs files, only their XML\n");
+	printf("  --no-dedup  write identical payloads as separate files, not hardlinks\n");
+	printf("  --cache <dir>  reuse results of unchanged inputs from <dir>\n");
+	printf("  --stats <file> write timings and counters per input as JSON lines (- for stdout, the rest then goes to stderr)\n");
+	printf("  --format <xml|json|bin>  output format, json is one object per element and line\n");
+	printf("  --schema    write the attribute types next to the XML, for --compile\n");
+	printf("  --raw-payload  write compressed payloads as stored (with --compile: read them that way)\n");
+}
 
-			if(strcmp(locale_link->name, "locale") == 0){
+int main(int argc, char *argv[]){
 
-				CXmlKeyValue *kv_src = NULL;
-				search_tag_key_by_name(locale_link, "src", &kv_src);
+	int res, nThread = 0, is_batch = 0;
+	const char *stats_path = NULL;
+	const char *compile_input = NULL, *compile_output = NULL;
+	const char *extract_id = NULL;
+	const char *grep_pattern = NULL;
+	BatchList list;
+	RcoDecompilerOption opt;
+
+	memset(&list, 0, sizeof(list));
+	memset(&opt, 0, sizeof(opt));
+
+	for(int i=1;i<argc;i++){
+		if(strcmp(argv[i], "-j") == 0 && (i + 1) < argc){
+			nThread = atoi(argv[++i]);
+			is_batch = 1;
+		}else if(strcmp(argv[i], "--no-rcs") == 0){
+			opt.flags |= RCO_DEC_FLAG_NO_RCS;
+		}else if(strcmp(argv[i], "--no-dedup") == 0){
+			opt.flags |= RCO_DEC_FLAG_NO_DEDUP;
+		}else if(strcmp(argv[i], "--cache") == 0 && (i + 1) < argc){
+			opt.cache_dir = argv[++i];
+		}else if(strcmp(argv[i], "--stats") == 0 && (i + 1) < argc){
+			stats_path = argv[++i];
+		}else if(strcmp(argv[i], "--raw-payload") == 0){
+			opt.flags |= RCO_DEC_FLAG_RAW_PAYLOAD;
+		}else if(strcmp(argv[i], "--format") == 0 && (i + 1) < argc){
+			i++;
+			opt.flags &= ~RCO_DEC_FORMAT_MASK;
+
+			if(strcmp(argv[i], "json") == 0){
+				opt.flags |= RCO_DEC_FORMAT_JSON;
+			}else if(strcmp(argv[i], "bin") == 0){
+				opt.flags |= RCO_DEC_FORMAT_BIN;
+			}else if(strcmp(argv[i], "xml") != 0){
+				usage(argv[0]);
+				return 1;
+			}
+		}else if(strcmp(argv[i], "--schema") == 0){
+			opt.flags |= RCO_DEC_FLAG_SCHEMA;
+		}else if(strcmp(argv[i], "--compile") == 0 && (i + 2) < argc){
+			compile_input  = argv[++i];
+			compile_output = argv[++i];
+		}else if(strcmp(argv[i], "--diff") == 0 && (i + 2) < argc){
+			// Same exit codes as diff(1)
+			res = RcoDiff(argv[i + 1], argv[i + 2]);
+			return (res < 0) ? 2 : res;
+		}else if(strcmp(argv[i], "--extract") == 0 && (i + 1) < argc){
+			extract_id = argv[++i];
+		}else if(strcmp(argv[i], "--grep") == 0 && (i + 1) < argc){
+			grep_pattern = argv[++i];
+		}else if(argv[i][0] == '-' && argv[i][1] != 0){
+			usage(argv[0]);
+			return 1;
+		}else{
+			struct stat stat_info;
+			if(stat(argv[i], &stat_info) == 0 && S_ISDIR(stat_info.st_mode)){
+				is_batch = 1;
+			}
 
-				printf("%s\n", kv_src->type_filename.output);
+			res = batch_list_add_path(&list, argv[i]);
+			if(res < 0){
+				return 1;
 			}
-			locale_link = locale_link->next;
 		}
 	}
 
-	return 0;
-}
-
-int xml_list_callback(FSListEntry *ent, void *argp){
-	// printf("%p %s\n", ent, ent->path_full);
+	if(compile_input != NULL){
+		ThreadPool *pPool = NULL;
+		RcoCompilerOption compile_opt;
 
+		memset(&compile_opt, 0, sizeof(compile_opt));
+		compile_opt.raw_payload = (opt.flags & RCO_DEC_FLAG_RAW_PAYLOAD) != 0;
 
-	int path_len = strlen(ent->path_full);
-	char *new_path = malloc(path_len + 1);
-	new_path[path_len] = 0;
-	memcpy(new_path, ent->path_full, path_len);
-
-	char *x = strrchr(new_path, '.');
-	*x = 0;
-
-	// printf("%s\n", new_path);
-
-	RcsDecompiler(new_path, ent->path_full, 0);
-
-	free(new_path);
-	new_path = NULL;
-
-	return 0;
-}
-
-int RcoDecompiler_core(const char *plugin_name, const void *rco_data, int rco_size){
-
-	int res;
-	const SceRcoHeader *pHeader;
-	CXmlTag *result;
-	char xml_name[0x40];
-	FILE *xml_fp;
+		if(thread_pool_create(&pPool, nThread) < 0){
+			pPool = NULL;
+		}
 
+		res = RcoCompiler(compile_input, compile_output, &compile_opt, pPool);
 
-	pHeader = (const SceRcoHeader *)rco_data;
+		thread_pool_destroy(pPool);
 
-	if(memcmp(pHeader->magic, "RCOF", 4) != 0){
-		printf("Header bad magic (%02X %02X %02X %02X)\n", pHeader->magic[0], pHeader->magic[1], pHeader->magic[2], pHeader->magic[3]);
-		return -1;
+		return (res < 0) ? 1 : 0;
 	}
 
-	snprintf(xml_name, sizeof(xml_name), "%s/", plugin_name);
-
-	res = create_file_with_recursive(xml_name, NULL, 0);
-	if(res < 0){
-		return res;
+	if(list.nJob == 0){
+		usage(argv[0]);
+		return 1;
 	}
 
-	snprintf(xml_name, sizeof(xml_name), "%s/%s.xml", plugin_name, plugin_name);
-
-
-	xml_fp = fopen(xml_name, "wb");
-	if(xml_fp == NULL){
-		return -1;
-	}
+	if(grep_pattern != NULL){
+		const char **paths = malloc(sizeof(*paths) * list.nJob);
+		if(paths == NULL){
+			return 2;
+		}
 
-	fprintf(xml_fp, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
+		for(int i=0;i<list.nJob;i++){
+			paths[i] = list.jobs[i].path;
+		}
 
-	res = parse_element(rco_data, (const void *)(rco_data + pHeader->tree_offset), NULL, &result);
-	if(res >= 0){
-		res = print_cxml(plugin_name, xml_fp, result, 0);
-	}
+		res = RcoGrep(paths, list.nJob, grep_pattern, nThread);
 
-	// TODO: Properly handle it here instead of inside print_cxml.
-	// process_stringtable(result);
+		for(int i=0;i<list.nJob;i++){
+			free(list.jobs[i].path);
+		}
 
-	free_cxml(result);
-	result = NULL;
+		free(paths);
+		free(list.jobs);
 
-	fclose(xml_fp);
-	xml_fp = NULL;
+		// Same exit codes as grep(1)
+		return (res < 0) ? 2 : ((res == 0) ? 1 : 0);
+	}
 
-	{
-		FSListEntry *ent = NULL;
+	if(extract_id != NULL){
+		res = 0;
 
-		snprintf(xml_name, sizeof(xml_name), "%s/locale", plugin_name);
+		for(int i=0;i<list.nJob;i++){
+			if(RcoExtract(list.jobs[i].path, extract_id, &opt) < 0){
+				printf("%s: cannot extract \"%s\"\n", list.jobs[i].path, extract_id);
+				res = -1;
+			}
 
-		int res = fs_list_init(xml_name, &ent, NULL, NULL);
-		if(res >= 0){
-			fs_list_execute(ent->child, xml_list_callback, NULL);
+			free(list.jobs[i].path);
 		}
-		fs_list_fini(ent);
-	}
 
-	return res;
-}
+		free(list.jobs);
 
-int RcoDecompiler(const char *path, int flags){
-
-	int res;
-	long length;
-	char *rco_data = NULL;
-
-	FILE *fp;
-	fp = fopen(path, "rb");
-	if(fp == NULL){
-		return -1;
+		return (res < 0) ? 1 : 0;
 	}
 
-	do {
-		fseek(fp, 0, SEEK_END);
-		length = ftell(fp);
-
-		rco_data = malloc(length);
-		if(rco_data == NULL){
-			res = -1;
-			break;
+	if(stats_path != NULL){
+		opt.stats_fp = (strcmp(stats_path, "-") == 0) ? stats_open_stdout() : fopen(stats_path, "w");
+		if(opt.stats_fp == NULL){
+			printf("cannot open \"%s\"\n", stats_path);
+			return 1;
 		}
+	}
 
-		fseek(fp, 0, SEEK_SET);
-		fread(rco_data, 1, (size_t)length, fp);
-
-		fclose(fp);
-		fp = NULL;
+	if(is_batch == 0 && list.nJob == 1){
+		ThreadPool *pPool = NULL;
 
-		{
-			const char *name = strrchr(path, '/');
-			if(name != NULL){
-				name = &(name[1]);
-			}else{
-				name = path;
-			}
-
-			const char *name_c = strrchr(name, '.');
-			if(name_c != NULL){
-				int name_len = name_c - name;
-				char *new_name = malloc(name_len + 1);
-				new_name[name_len] = 0;
-				memcpy(new_name, name, name_len);
-				res = RcoDecompiler_core(new_name, rco_data, length);
-				free(new_name);
-				new_name = NULL;
-			}else{
-				res = RcoDecompiler_core(name, rco_data, length);
-			}
+		if(thread_pool_create(&pPool, nThread) < 0){
+			pPool = NULL;
 		}
 
-		free(rco_data);
-		rco_data = NULL;
-	} while(0);
+		res = RcoDecompiler(list.jobs[0].path, &opt, NULL, pPool);
 
-	return res;
-}
+		thread_pool_destroy(pPool);
+	}else{
+		res = RcoDecompiler_batch(&list, nThread, &opt);
+	}
 
-int main(int argc, char *argv[]){
+	for(int i=0;i<list.nJob;i++){
+		free(list.jobs[i].path);
+	}
 
-	int res;
+	free(list.jobs);
+
+	if(opt.stats_fp != NULL){
+		fclose(opt.stats_fp);
+	}
 
-	res = RcoDecompiler(argv[1], 0);
 	if(res < 0){
 		return 1;
 	}
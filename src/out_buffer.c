@@ -0,0 +1,225 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "out_buffer.h"
+
+
+static const char digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char hex_digits[16] = "0123456789ABCDEF";
+
+#define INDENT_SIZE (0x100)
+
+static const char indent_spaces[INDENT_SIZE + 1] =
+	"                                                                "
+	"                                                                "
+	"                                                                "
+	"                                                                ";
+
+int out_buffer_init(OutBuffer *pBuf, FILE *fp, size_t size){
+
+	if(size == 0){
+		size = 0x40000;
+	}
+
+	pBuf->data = malloc(size);
+	if(pBuf->data == NULL){
+		return -1;
+	}
+
+	pBuf->fp    = fp;
+	pBuf->size  = size;
+	pBuf->pos   = 0;
+	pBuf->error = 0;
+
+	// The block is already buffered here, stdio does not need a second copy
+	setvbuf(fp, NULL, _IONBF, 0);
+
+	return 0;
+}
+
+int out_buffer_fini(OutBuffer *pBuf){
+
+	int res;
+
+	res = out_buffer_flush(pBuf);
+
+	free(pBuf->data);
+	pBuf->data = NULL;
+	pBuf->size = 0;
+
+	if(pBuf->error != 0){
+		return -1;
+	}
+
+	return res;
+}
+
+int out_buffer_flush(OutBuffer *pBuf){
+
+	if(pBuf->pos != 0){
+		if(fwrite(pBuf->data, 1, pBuf->pos, pBuf->fp) != pBuf->pos){
+			pBuf->error = 1;
+		}
+
+		pBuf->pos = 0;
+	}
+
+	if(pBuf->error != 0){
+		return -1;
+	}
+
+	return 0;
+}
+
+char *out_buffer_reserve(OutBuffer *pBuf, size_t size){
+
+	if((pBuf->size - pBuf->pos) >= size){
+		return &(pBuf->data[pBuf->pos]);
+	}
+
+	out_buffer_flush(pBuf);
+
+	if(pBuf->size < size){
+		char *data = realloc(pBuf->data, size);
+		if(data == NULL){
+			pBuf->error = 1;
+			return NULL;
+		}
+
+		pBuf->data = data;
+		pBuf->size = size;
+	}
+
+	return pBuf->data;
+}
+
+int out_buffer_write(OutBuffer *pBuf, const void *data, size_t size){
+
+	if((pBuf->size - pBuf->pos) < size){
+		if(out_buffer_flush(pBuf) < 0){
+			return -1;
+		}
+
+		// Too large to be worth copying, pass it straight through
+		if(size >= pBuf->size){
+			if(fwrite(data, 1, size, pBuf->fp) != size){
+				pBuf->error = 1;
+				return -1;
+			}
+
+			return 0;
+		}
+	}
+
+	memcpy(&(pBuf->data[pBuf->pos]), data, size);
+	pBuf->pos += size;
+
+	return 0;
+}
+
+int out_buffer_print_int(OutBuffer *pBuf, int value){
+
+	char tmp[0x10];
+	char *end = &tmp[sizeof(tmp)], *p = end;
+	uint32_t v;
+
+	v = (value < 0) ? (0U - (uint32_t)value) : (uint32_t)value;
+
+	while(v >= 100){
+		uint32_t n = (v % 100) * 2;
+		v /= 100;
+		*--p = digit_pairs[n + 1];
+		*--p = digit_pairs[n];
+	}
+
+	if(v >= 10){
+		*--p = digit_pairs[v * 2 + 1];
+		*--p = digit_pairs[v * 2];
+	}else{
+		*--p = '0' + v;
+	}
+
+	if(value < 0){
+		*--p = '-';
+	}
+
+	return out_buffer_write(pBuf, p, end - p);
+}
+
+int out_buffer_print_hex32(OutBuffer *pBuf, uint32_t value){
+
+	char *p = out_buffer_reserve(pBuf, 10);
+	if(p == NULL){
+		return -1;
+	}
+
+	p[0] = '0';
+	p[1] = 'x';
+
+	for(int i=0;i<8;i++){
+		p[2 + i] = hex_digits[(value >> (28 - i * 4)) & 0xF];
+	}
+
+	pBuf->pos += 10;
+
+	return 0;
+}
+
+int out_buffer_print_float(OutBuffer *pBuf, float value){
+
+	char *p = out_buffer_reserve(pBuf, 0x20);
+	if(p == NULL){
+		return -1;
+	}
+
+	pBuf->pos += snprintf(p, 0x20, "%g", value);
+
+	return 0;
+}
+
+int out_buffer_print_float_exact(OutBuffer *pBuf, float value){
+
+	char *p = out_buffer_reserve(pBuf, 0x20);
+	if(p == NULL){
+		return -1;
+	}
+
+	int len = snprintf(p, 0x20, "%g", value);
+
+	// Nine significant digits always read back to the same float
+	float parsed = strtof(p, NULL);
+	if(memcmp(&parsed, &value, sizeof(value)) != 0){
+		len = snprintf(p, 0x20, "%.9g", value);
+	}
+
+	pBuf->pos += len;
+
+	return 0;
+}
+
+int out_buffer_print_indent(OutBuffer *pBuf, int level){
+
+	int n = level * 2;
+
+	while(n > INDENT_SIZE){
+		if(out_buffer_write(pBuf, indent_spaces, INDENT_SIZE) < 0){
+			return -1;
+		}
+
+		n -= INDENT_SIZE;
+	}
+
+	return out_buffer_write(pBuf, indent_spaces, n);
+}
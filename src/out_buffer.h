@@ -0,0 +1,64 @@
+
+#ifndef _OUT_BUFFER_H_
+#define _OUT_BUFFER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+
+typedef struct OutBuffer {
+	FILE *fp;
+	char *data;
+	size_t size;
+	size_t pos;
+	int error;
+} OutBuffer;
+
+/*
+ * Output is collected in a block of size bytes and handed to fp with one
+ * fwrite per block. fp is not closed by out_buffer_fini.
+ */
+int out_buffer_init(OutBuffer *pBuf, FILE *fp, size_t size);
+int out_buffer_fini(OutBuffer *pBuf);
+int out_buffer_flush(OutBuffer *pBuf);
+
+/*
+ * Returns room for at least size bytes at the current position. The caller
+ * advances pBuf->pos by the number of bytes it actually wrote.
+ */
+char *out_buffer_reserve(OutBuffer *pBuf, size_t size);
+
+int out_buffer_write(OutBuffer *pBuf, const void *data, size_t size);
+int out_buffer_print_int(OutBuffer *pBuf, int value);
+int out_buffer_print_hex32(OutBuffer *pBuf, uint32_t value);
+int out_buffer_print_float(OutBuffer *pBuf, float value);
+int out_buffer_print_float_exact(OutBuffer *pBuf, float value); // %g, or %.9g if strtof would not read %g back to value
+int out_buffer_print_indent(OutBuffer *pBuf, int level);
+
+static inline int out_buffer_putc(OutBuffer *pBuf, char c){
+
+	if(pBuf->pos == pBuf->size && out_buffer_flush(pBuf) < 0){
+		return -1;
+	}
+
+	pBuf->data[pBuf->pos++] = c;
+
+	return 0;
+}
+
+static inline int out_buffer_puts(OutBuffer *pBuf, const char *str){
+	return out_buffer_write(pBuf, str, strlen(str));
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OUT_BUFFER_H_ */
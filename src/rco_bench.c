@@ -0,0 +1,398 @@
+#define _XOPEN_SOURCE 700
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ftw.h>
+#include <unistd.h>
+#include "arena.h"
+#include "out_buffer.h"
+#include "thread_pool.h"
+#include "rco_decompiler.h"
+#include "rco_gen.h"
+
+
+typedef struct BenchFile {
+	char name[0x20];
+	void *data;
+	size_t size;
+	long nElement;
+} BenchFile;
+
+typedef struct BenchResult {
+	const char *name;
+	double best;  // seconds, fastest iteration over the whole corpus
+	double total;
+	size_t nOutput; // bytes written by one iteration, 0 when not measured
+} BenchResult;
+
+double bench_now(void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+void bench_result_add(BenchResult *result, double elapsed){
+
+	if(result->total == 0.0 || elapsed < result->best){
+		result->best = elapsed;
+	}
+
+	result->total += elapsed;
+}
+
+long bench_count_elements(const CXmlTag *cxml){
+
+	long n = 0;
+
+	while(cxml != NULL){
+		n++;
+
+		if(cxml->child != NULL){
+			cxml = cxml->child;
+			continue;
+		}
+
+		while(cxml->next == NULL && cxml->parent != NULL){
+			cxml = cxml->parent;
+		}
+
+		cxml = cxml->next;
+	}
+
+	return n;
+}
+
+const CXmlTag *bench_parse(Arena *arena, const BenchFile *file){
+
+	const SceRcoHeader *pHeader = (const SceRcoHeader *)file->data;
+	CXmlTag *result = NULL;
+
+	if(parse_element(arena, file->data, file->data + pHeader->tree_offset, NULL, &result) < 0){
+		return NULL;
+	}
+
+	return result;
+}
+
+int bench_run_parse(Arena *arena, BenchFile *files, int nFile, BenchResult *result){
+
+	double start = bench_now();
+
+	for(int i=0;i<nFile;i++){
+		const CXmlTag *cxml = bench_parse(arena, &(files[i]));
+		if(cxml == NULL){
+			return -1;
+		}
+
+		files[i].nElement = bench_count_elements(cxml);
+		arena_reset(arena);
+	}
+
+	bench_result_add(result, bench_now() - start);
+
+	return 0;
+}
+
+// Tree printing only, the payloads get their paths but are not written
+int bench_run_print(Arena *arena, BenchFile *files, int nFile, BenchResult *result){
+
+	int res = 0;
+	double elapsed = 0.0;
+	RcoDecompilerContext ctx;
+
+	result->nOutput = 0;
+
+	for(int i=0;i<nFile && res >= 0;i++){
+		const CXmlTag *cxml = bench_parse(arena, &(files[i]));
+		if(cxml == NULL){
+			return -1;
+		}
+
+		FILE *fp = fopen("print.xml", "wb");
+		if(fp == NULL){
+			return -1;
+		}
+
+		OutBuffer out;
+
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.arena       = arena;
+		ctx.output_path = files[i].name;
+		ctx.flags       = RCO_DEC_FLAG_NO_PAYLOAD;
+
+		double start = bench_now();
+
+		res = out_buffer_init(&out, fp, 0);
+		if(res >= 0){
+			res = print_cxml(&ctx, &out, (CXmlTag *)cxml, 0);
+			if(out_buffer_fini(&out) < 0 && res >= 0){
+				res = -1;
+			}
+		}
+
+		elapsed += bench_now() - start;
+
+		result->nOutput += ftell(fp);
+		fclose(fp);
+
+		arena_reset(arena);
+	}
+
+	bench_result_add(result, elapsed);
+
+	return res;
+}
+
+int bench_run_extract(Arena *arena, ThreadPool *pool, int flags, BenchFile *files, int nFile, BenchResult *result){
+
+	int res = 0;
+	RcoDecompilerContext ctx;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.arena = arena;
+	ctx.pool  = pool;
+	ctx.flags = flags;
+
+	double start = bench_now();
+
+	for(int i=0;i<nFile && res >= 0;i++){
+		res = RcoDecompiler_core(files[i].name, files[i].data, files[i].size, &ctx);
+	}
+
+	bench_result_add(result, bench_now() - start);
+
+	return res;
+}
+
+int bench_remove_entry(const char *path, const struct stat *stat_info, int flag, struct FTW *ftw){
+
+	(void)stat_info;
+	(void)flag;
+	(void)ftw;
+
+	return remove(path);
+}
+
+void usage(const char *argv0){
+	printf("usage: %s [options]\n", argv0);
+	printf("  --generate <file>   write one generated file and exit\n");
+	printf("  --rcs               generate a locale RCSF instead of a plugin RCOF\n");
+	printf("  --files <n>         files in the corpus (default: 4)\n");
+	printf("  --iterations <n>    runs of each phase (default: 5)\n");
+	printf("  -j <n>              worker threads for extract (default: cpu count)\n");
+	printf("  --pages <n>         pages per plugin\n");
+	printf("  --depth <n>         plane levels below each page\n");
+	printf("  --siblings <n>      planes per level\n");
+	printf("  --attrs <n>         attributes per plane\n");
+	printf("  --attr-mask <hex>   (1 << attr_type) of the attribute types to use\n");
+	printf("  --wstring <n>       UTF-16 units per wstring\n");
+	printf("  --locales <n>       locale RCS per plugin\n");
+	printf("  --strings <n>       strings per locale\n");
+	printf("  --payloads <n>      textures per plugin\n");
+	printf("  --payload-size <n>  bytes per texture before compression\n");
+	printf("  --no-compress       store payloads and locales uncompressed\n");
+	printf("  --seed <n>          first random seed\n");
+	printf("  --keep              keep the work directory\n");
+}
+
+void bench_print_result(const BenchResult *result, size_t input_size, long nElement){
+
+	double mb = (double)input_size / (1024.0 * 1024.0);
+
+	printf("%-8s %10.3f %10.3f %10.1f %12.0f",
+		result->name, result->best * 1000.0, result->total * 1000.0, mb / result->best, (double)nElement / result->best);
+
+	if(result->nOutput != 0){
+		printf("  (%.1f MB/s out)", ((double)result->nOutput / (1024.0 * 1024.0)) / result->best);
+	}
+
+	printf("\n");
+}
+
+int main(int argc, char *argv[]){
+
+	int res, nFile = 4, nIteration = 5, nThread = 0, keep = 0;
+	const char *generate_path = NULL;
+	RcoGenParam param;
+
+	rco_gen_default_param(&param);
+
+	for(int i=1;i<argc;i++){
+		const char *arg = argv[i];
+		const char *value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+		if(strcmp(arg, "--rcs") == 0){
+			param.is_rcs = 1;
+		}else if(strcmp(arg, "--no-compress") == 0){
+			param.compress = 0;
+		}else if(strcmp(arg, "--keep") == 0){
+			keep = 1;
+		}else if(value == NULL){
+			usage(argv[0]);
+			return 1;
+		}else{
+			i++;
+
+			if(strcmp(arg, "--generate") == 0){
+				generate_path = value;
+			}else if(strcmp(arg, "--files") == 0){
+				nFile = atoi(value);
+			}else if(strcmp(arg, "--iterations") == 0){
+				nIteration = atoi(value);
+			}else if(strcmp(arg, "-j") == 0){
+				nThread = atoi(value);
+			}else if(strcmp(arg, "--pages") == 0){
+				param.nPage = atoi(value);
+			}else if(strcmp(arg, "--depth") == 0){
+				param.depth = atoi(value);
+			}else if(strcmp(arg, "--siblings") == 0){
+				param.nSibling = atoi(value);
+			}else if(strcmp(arg, "--attrs") == 0){
+				param.nAttribute = atoi(value);
+			}else if(strcmp(arg, "--attr-mask") == 0){
+				param.attr_mask = strtol(value, NULL, 16);
+			}else if(strcmp(arg, "--wstring") == 0){
+				param.wstring_length = atoi(value);
+			}else if(strcmp(arg, "--locales") == 0){
+				param.nLocale = atoi(value);
+			}else if(strcmp(arg, "--strings") == 0){
+				param.nLocaleString = atoi(value);
+			}else if(strcmp(arg, "--payloads") == 0){
+				param.nPayload = atoi(value);
+			}else if(strcmp(arg, "--payload-size") == 0){
+				param.payload_size = atoi(value);
+			}else if(strcmp(arg, "--seed") == 0){
+				param.seed = strtoul(value, NULL, 0);
+			}else{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if(generate_path != NULL){
+		void *data;
+		size_t size;
+
+		res = rco_gen_build(&param, &data, &size);
+		if(res < 0){
+			printf("cannot generate\n");
+			return 1;
+		}
+
+		FILE *fp = fopen(generate_path, "wb");
+		if(fp == NULL || fwrite(data, size, 1, fp) != 1){
+			printf("cannot write \"%s\"\n", generate_path);
+			res = -1;
+		}
+
+		if(fp != NULL && fclose(fp) != 0){
+			res = -1;
+		}
+
+		free(data);
+
+		return (res < 0) ? 1 : 0;
+	}
+
+	if(param.is_rcs != 0 || nFile < 1 || nIteration < 1){
+		printf("the benchmark needs at least one plugin RCOF and one iteration\n");
+		return 1;
+	}
+
+	BenchFile *files = calloc(nFile, sizeof(*files));
+	if(files == NULL){
+		return 1;
+	}
+
+	size_t input_size = 0;
+
+	for(int i=0;i<nFile;i++){
+		RcoGenParam file_param = param;
+
+		file_param.seed = param.seed + i;
+
+		snprintf(files[i].name, sizeof(files[i].name), "bench_%d", i);
+
+		if(rco_gen_build(&file_param, &(files[i].data), &(files[i].size)) < 0){
+			printf("cannot generate\n");
+			return 1;
+		}
+
+		input_size += files[i].size;
+	}
+
+	char work_dir[] = "/tmp/rco_bench.XXXXXX";
+	if(mkdtemp(work_dir) == NULL || chdir(work_dir) != 0){
+		printf("cannot create a work directory\n");
+		return 1;
+	}
+
+	ThreadPool *pPool = NULL;
+	if(thread_pool_create(&pPool, nThread) < 0){
+		pPool = NULL;
+	}
+
+	Arena arena;
+	arena_init(&arena, 0);
+
+	BenchResult results[3];
+	memset(results, 0, sizeof(results));
+	results[0].name = "parse";
+	results[1].name = "print";
+	results[2].name = "extract";
+
+	res = 0;
+
+	for(int i=0;i<nIteration && res >= 0;i++){
+		res = bench_run_parse(&arena, files, nFile, &results[0]);
+		if(res >= 0){
+			res = bench_run_print(&arena, files, nFile, &results[1]);
+		}
+
+		if(res >= 0){
+			res = bench_run_extract(&arena, pPool, 0, files, nFile, &results[2]);
+		}
+	}
+
+	long nElement = 0;
+	for(int i=0;i<nFile;i++){
+		nElement += files[i].nElement;
+	}
+
+	if(res < 0){
+		printf("benchmark failed (0x%X)\n", res);
+	}else{
+		printf("corpus: %d files, %.2f MiB, %ld elements, %d threads, %d iterations\n",
+			nFile, (double)input_size / (1024.0 * 1024.0), nElement, thread_pool_get_thread_count(pPool), nIteration);
+		printf("%-8s %10s %10s %10s %12s\n", "phase", "best ms", "total ms", "MB/s", "elements/s");
+
+		for(int i=0;i<3;i++){
+			bench_print_result(&results[i], input_size, nElement);
+		}
+	}
+
+	arena_fini(&arena);
+	thread_pool_destroy(pPool);
+
+	for(int i=0;i<nFile;i++){
+		free(files[i].data);
+	}
+
+	free(files);
+
+	if(keep != 0){
+		printf("work directory: %s\n", work_dir);
+	}else{
+		if(chdir("/") == 0){
+			nftw(work_dir, bench_remove_entry, 0x10, FTW_DEPTH | FTW_PHYS);
+		}
+	}
+
+	return (res < 0) ? 1 : 0;
+}
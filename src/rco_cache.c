@@ -0,0 +1,166 @@
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fs_list.h"
+#include "file_util.h"
+#include "hash_table.h"
+#include "version.h"
+#include "rco_cache.h"
+
+
+typedef struct RcoCacheCopyParam {
+	const char *src_root;
+	const char *dst_root;
+	int res;
+} RcoCacheCopyParam;
+
+int rco_cache_make_key(char key[RCO_CACHE_KEY_SIZE], const void *data, size_t size, const char *name, int flags){
+
+	uint64_t h;
+
+	h = hash_table_hash_bytes(RCO_DECOMPILER_VERSION, strlen(RCO_DECOMPILER_VERSION), 0);
+	h = hash_table_hash_bytes(name, strlen(name), h);
+	h = hash_table_hash_bytes(&flags, sizeof(flags), h);
+	h = hash_table_hash_bytes(data, size, h);
+
+	snprintf(key, RCO_CACHE_KEY_SIZE, "%016llx", (unsigned long long)h);
+
+	return 0;
+}
+
+static int rco_cache_copy_callback(FSListEntry *ent, void *argp){
+
+	RcoCacheCopyParam *param = (RcoCacheCopyParam *)argp;
+
+	if(ent->isDir != 0 || ent->name == NULL){
+		return 0;
+	}
+
+	const char *rel = ent->path_full + strlen(param->src_root) + 1;
+	int path_len = strlen(param->dst_root) + 1 + strlen(rel);
+
+	char *dst = malloc(path_len + 1);
+	if(dst == NULL){
+		param->res = -1;
+		return -1;
+	}
+
+	snprintf(dst, path_len + 1, "%s/%s", param->dst_root, rel);
+
+	if(link_or_copy_file(ent->path_full, dst) < 0){
+		printf("cache: cannot link \"%s\"\n", dst);
+		param->res = -1;
+	}
+
+	free(dst);
+
+	return param->res;
+}
+
+static int rco_cache_copy_tree(const char *src_root, const char *dst_root){
+
+	int res;
+	FSListEntry *ent = NULL;
+	RcoCacheCopyParam param;
+
+	res = fs_list_init(src_root, &ent, NULL, NULL);
+	if(res < 0){
+		return res;
+	}
+
+	param.src_root = src_root;
+	param.dst_root = dst_root;
+	param.res      = 0;
+
+	fs_list_execute(ent->child, rco_cache_copy_callback, &param);
+	fs_list_fini(ent);
+
+	return param.res;
+}
+
+static int rco_cache_remove_callback(FSListEntry *ent, void *argp){
+
+	(void)argp;
+
+	remove(ent->path_full);
+
+	return 0;
+}
+
+static int rco_cache_remove_tree(const char *root){
+
+	int res;
+	FSListEntry *ent = NULL;
+
+	res = fs_list_init(root, &ent, NULL, NULL);
+	if(res < 0){
+		return res;
+	}
+
+	// Children come before their parent, so directories are empty by then
+	fs_list_execute2(ent, rco_cache_remove_callback, NULL);
+	fs_list_fini(ent);
+
+	return 0;
+}
+
+int rco_cache_restore(const char *cache_dir, const char *key, const char *output_dir){
+
+	char entry_path[0x400];
+	struct stat stat_info;
+
+	snprintf(entry_path, sizeof(entry_path), "%s/%s", cache_dir, key);
+
+	if(stat(entry_path, &stat_info) != 0 || !S_ISDIR(stat_info.st_mode)){
+		return 1;
+	}
+
+	return rco_cache_copy_tree(entry_path, output_dir);
+}
+
+int rco_cache_store(const char *cache_dir, const char *key, const char *output_dir){
+
+	int res;
+	char entry_path[0x400], temp_path[0x400];
+
+	snprintf(entry_path, sizeof(entry_path), "%s/%s", cache_dir, key);
+	snprintf(temp_path, sizeof(temp_path), "%s/%s.tmp.%d.%lx", cache_dir, key, (int)getpid(), (unsigned long)pthread_self());
+
+	res = rco_cache_copy_tree(output_dir, temp_path);
+
+	// Publish the entry in one step, or drop ours if another job was first
+	if(res < 0 || rename(temp_path, entry_path) != 0){
+		rco_cache_remove_tree(temp_path);
+	}
+
+	return res;
+}
+
+void rco_cache_make_temp_name(char *path, size_t size, const char *output_dir){
+	snprintf(path, size, "%s.tmp.%d.%lx", output_dir, (int)getpid(), (unsigned long)pthread_self());
+}
+
+int rco_cache_publish(const char *cache_dir, const char *key, const char *temp_dir, const char *output_dir){
+
+	int res;
+
+	if(rco_cache_store(cache_dir, key, temp_dir) < 0){
+		printf("cache: cannot store %s\n", key);
+	}
+
+	// The entry and the output share the inodes of temp_dir, which goes away
+	res = rco_cache_copy_tree(temp_dir, output_dir);
+
+	rco_cache_remove_tree(temp_dir);
+
+	return res;
+}
+
+void rco_cache_discard(const char *temp_dir){
+	rco_cache_remove_tree(temp_dir);
+}
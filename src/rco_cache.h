@@ -0,0 +1,50 @@
+
+#ifndef _RCO_CACHE_H_
+#define _RCO_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+
+
+#define RCO_CACHE_KEY_SIZE (0x20)
+
+/*
+ * The key covers the input bytes, the output name, the flags that change
+ * the output and the tool version.
+ */
+int rco_cache_make_key(char key[RCO_CACHE_KEY_SIZE], const void *data, size_t size, const char *name, int flags);
+
+/*
+ * Links a cached result into output_dir. The output and the entry share
+ * inodes, which is safe because every writer replaces a file
+ * (create_output_file) instead of rewriting it in place.
+ * Returns 0 on a hit, 1 if there is no entry for key and < 0 on error.
+ */
+int rco_cache_restore(const char *cache_dir, const char *key, const char *output_dir);
+
+/*
+ * Stores every file below output_dir as the entry for key. Entries appear
+ * atomically, so a concurrent reader never sees a partial one.
+ */
+int rco_cache_store(const char *cache_dir, const char *key, const char *output_dir);
+
+/*
+ * A miss is decompiled into a temporary directory next to output_dir, so the
+ * entry holds only the files of this run and never stale ones from earlier
+ * runs into output_dir. rco_cache_publish stores it as the entry for key,
+ * links it into output_dir and removes it; rco_cache_discard only removes it.
+ */
+void rco_cache_make_temp_name(char *path, size_t size, const char *output_dir);
+int rco_cache_publish(const char *cache_dir, const char *key, const char *temp_dir, const char *output_dir);
+void rco_cache_discard(const char *temp_dir);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_CACHE_H_ */
@@ -0,0 +1,546 @@
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+#include "arena.h"
+#include "file_map.h"
+#include "file_util.h"
+#include "utf16_xml.h"
+#include "rco_writer.h"
+#include "rco_decompiler.h"
+#include "rco_compiler.h"
+
+
+typedef struct CompileJob {
+	char *path;
+	int is_locale;
+	int compress;
+	int origsize_hint; // origsize from the XML, for payloads that are already compressed
+	const RcoCompilerOption *opt;
+	void *data; // as stored in the filetable
+	size_t size;
+	size_t origsize;
+} CompileJob;
+
+typedef struct CompileJobList {
+	CompileJob *jobs;
+	int nJob;
+	int nMax;
+} CompileJobList;
+
+int rco_compiler_get_type(const RcoSchema *schema, const XmlNode *node, const XmlAttribute *attr){
+
+	int type = 0;
+
+	if(schema != NULL){
+		type = rco_schema_get(schema, node->name, attr->name);
+	}
+
+	if(type == 0){
+		type = rco_schema_guess(node->name, attr->name, attr->value);
+	}
+
+	return type;
+}
+
+// A locale .rcs is rebuilt from the XML next to it, so edits to the XML are picked up
+int compile_job_load_locale(CompileJob *job, void **ppData, size_t *pSize){
+
+	int res;
+	size_t len = strlen(job->path);
+	char *xml_path;
+	struct stat stat_info;
+
+	if(len <= 4 || strcmp(&(job->path[len - 4]), ".rcs") != 0){
+		return 1;
+	}
+
+	xml_path = malloc(len - 4 + 1);
+	if(xml_path == NULL){
+		return -1;
+	}
+
+	memcpy(xml_path, job->path, len - 4);
+	xml_path[len - 4] = 0;
+
+	if(stat(xml_path, &stat_info) != 0){
+		free(xml_path);
+		return 1;
+	}
+
+	FileMap map;
+	Arena arena;
+	XmlNode *root;
+
+	res = file_map_open(xml_path, &map);
+	if(res >= 0){
+		arena_init(&arena, 0);
+
+		res = xml_reader_parse(&arena, map.data, map.size, &root);
+		if(res >= 0){
+			res = RcoCompiler_core(root, NULL, NULL, "RCSF", job->opt, NULL, ppData, pSize);
+		}
+
+		if(res < 0){
+			printf("cannot compile \"%s\"\n", xml_path);
+		}
+
+		arena_fini(&arena);
+		file_map_close(&map);
+	}
+
+	free(xml_path);
+
+	return res;
+}
+
+int compile_job_entry(void *argp){
+
+	int res;
+	CompileJob *job = (CompileJob *)argp;
+	void *data = NULL;
+	size_t size = 0;
+	FileMap map;
+	int is_mapped = 0;
+
+	res = 1;
+
+	if(job->is_locale != 0){
+		res = compile_job_load_locale(job, &data, &size);
+		if(res < 0){
+			return res;
+		}
+	}
+
+	if(res > 0){
+		res = file_map_open(job->path, &map);
+		if(res < 0){
+			printf("cannot open \"%s\"\n", job->path);
+			return res;
+		}
+
+		is_mapped = 1;
+		data = map.data;
+		size = map.size;
+	}
+
+	job->origsize = size;
+
+	if(job->compress != 0 && is_mapped != 0 && job->opt->raw_payload != 0){
+		// Written as stored by --raw-payload, keep the bits and the origsize of the XML
+		job->data = malloc((size != 0) ? size : 1);
+		if(job->data != NULL){
+			memcpy(job->data, data, size);
+			job->size     = size;
+			job->origsize = job->origsize_hint;
+		}
+	}else if(job->compress != 0){
+		uLongf dst_size = compressBound(size);
+
+		job->data = malloc(dst_size);
+		if(job->data != NULL){
+			if(compress2(job->data, &dst_size, data, size, (job->opt->level != 0) ? job->opt->level : Z_DEFAULT_COMPRESSION) != Z_OK){
+				printf("cannot compress \"%s\"\n", job->path);
+				free(job->data);
+				job->data = NULL;
+			}
+
+			job->size = dst_size;
+		}
+	}else{
+		job->data = malloc((size != 0) ? size : 1);
+		if(job->data != NULL){
+			memcpy(job->data, data, size);
+			job->size = size;
+		}
+	}
+
+	if(is_mapped != 0){
+		file_map_close(&map);
+	}else{
+		free(data);
+	}
+
+	return (job->data != NULL) ? 0 : -1;
+}
+
+int compile_job_list_add(CompileJobList *pList, Arena *arena, const char *base_dir, const XmlNode *node, const XmlAttribute *attr, const RcoCompilerOption *opt){
+
+	if(pList->nJob == pList->nMax){
+		int nMax = (pList->nMax == 0) ? 0x40 : pList->nMax * 2;
+		CompileJob *jobs = realloc(pList->jobs, sizeof(*jobs) * nMax);
+		if(jobs == NULL){
+			return -1;
+		}
+
+		pList->jobs = jobs;
+		pList->nMax = nMax;
+	}
+
+	CompileJob *job = &(pList->jobs[pList->nJob]);
+	const XmlAttribute *compress = xml_node_get_attribute(node, "compress");
+	const XmlAttribute *origsize = xml_node_get_attribute(node, "origsize");
+
+	memset(job, 0, sizeof(*job));
+
+	size_t path_size = strlen(base_dir) + 1 + attr->value_len + 1;
+
+	job->path = arena_alloc(arena, path_size);
+	if(job->path == NULL){
+		return -1;
+	}
+
+	snprintf(job->path, path_size, "%s/%s", base_dir, attr->value);
+
+	job->is_locale = (strcmp(node->name, "locale") == 0);
+	job->compress  = (compress != NULL && strcmp(compress->value, "on") == 0);
+	job->opt       = opt;
+
+	if(origsize != NULL){
+		job->origsize_hint = strtol(origsize->value, NULL, 10);
+	}
+
+	pList->nJob++;
+
+	return 0;
+}
+
+// Document order with parent links, the same order both passes see
+const XmlNode *rco_compiler_next_node(const XmlNode *node){
+
+	if(node->child != NULL){
+		return node->child;
+	}
+
+	while(node->next == NULL && node->parent != NULL){
+		node = node->parent;
+	}
+
+	return node->next;
+}
+
+int rco_compiler_parse_array(Arena *arena, const char *value, int is_float, void **ppData, int *pCount){
+
+	int count = 0;
+	const char *p = value;
+
+	while(*p == ' '){
+		p++;
+	}
+
+	if(*p != 0){
+		count = 1;
+		for(const char *s=p;*s!=0;s++){
+			if(*s == ','){
+				count++;
+			}
+		}
+	}
+
+	int32_t *data = arena_alloc(arena, (count != 0) ? count * sizeof(int32_t) : sizeof(int32_t));
+	if(data == NULL){
+		return -1;
+	}
+
+	for(int i=0;i<count;i++){
+		char *end;
+
+		if(is_float != 0){
+			float f = strtof(p, &end);
+			memcpy(&(data[i]), &f, sizeof(f));
+		}else{
+			data[i] = strtol(p, &end, 10);
+		}
+
+		if(end == p){
+			return -1;
+		}
+
+		p = end;
+		while(*p == ' ' || *p == ','){
+			p++;
+		}
+	}
+
+	*ppData = data;
+	*pCount = count;
+
+	return 0;
+}
+
+int rco_compiler_add_attribute(RcoWriter *writer, RcoWriterElement *elm, Arena *arena, const XmlNode *node, const XmlAttribute *attr, int type, const CompileJob *job){
+
+	const char *value = attr->value;
+
+	switch(type){
+	case attr_type_int:
+		// The payload may have been edited, so the size comes from the file
+		if(job != NULL && job->compress != 0 && strcmp(attr->name, "origsize") == 0){
+			return rco_writer_add_int(writer, elm, attr->name, job->origsize);
+		}
+
+		return rco_writer_add_int(writer, elm, attr->name, strtol(value, NULL, 10));
+	case attr_type_float:
+		return rco_writer_add_float(writer, elm, attr->name, strtof(value, NULL));
+	case attr_type_string:
+		return rco_writer_add_string(writer, elm, attr->name, value);
+	case attr_type_wstring:
+		{
+			uint16_t *wstr = arena_alloc(arena, (attr->value_len + 1) * sizeof(uint16_t));
+			if(wstr == NULL){
+				return -1;
+			}
+
+			size_t len = utf8_to_utf16(wstr, value, attr->value_len);
+
+			return rco_writer_add_wstring(writer, elm, attr->name, wstr, len);
+		}
+	case attr_type_hash:
+		return rco_writer_add_hash(writer, elm, attr->name, strtoul(value, NULL, 16));
+	case attr_type_intarray:
+	case attr_type_floatarray:
+		{
+			void *data;
+			int count;
+
+			if(rco_compiler_parse_array(arena, value, type == attr_type_floatarray, &data, &count) < 0){
+				printf("line %d: bad array in %s\n", node->line, attr->name);
+				return -1;
+			}
+
+			if(type == attr_type_floatarray){
+				return rco_writer_add_floatarray(writer, elm, attr->name, data, count);
+			}
+
+			return rco_writer_add_intarray(writer, elm, attr->name, data, count);
+		}
+	case attr_type_filename:
+		return rco_writer_add_file(writer, elm, attr->name, job->data, job->size);
+	case attr_type_id:
+		return rco_writer_add_id(writer, elm, attr->name, value);
+	case attr_type_idref:
+		return rco_writer_add_idref(writer, elm, attr->name);
+	case attr_type_idhash:
+		return rco_writer_add_idhash(writer, elm, attr->name, strtoul(value, NULL, 16));
+	case attr_type_idhashref:
+		return rco_writer_add_idhashref(writer, elm, attr->name, strtoul(value, NULL, 16));
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+int RcoCompiler_core(const XmlNode *root, const char *base_dir, const RcoSchema *schema, const char *magic, const RcoCompilerOption *opt, ThreadPool *pool, void **ppData, size_t *pSize){
+
+	int res = 0, nJob;
+	Arena arena;
+	CompileJobList list;
+	RcoWriter *writer = NULL;
+	RcoWriterElement *parent = NULL, *elm;
+	const XmlNode *node;
+
+	*ppData = NULL;
+	*pSize  = 0;
+
+	memset(&list, 0, sizeof(list));
+	arena_init(&arena, 0);
+
+	/*
+	 * Pass 1 collects the payloads and starts reading and compressing them,
+	 * pass 2 builds the tables once they are all done.
+	 */
+	for(node=root;node!=NULL && res >= 0;node=rco_compiler_next_node(node)){
+		for(const XmlAttribute *attr=node->attr;attr!=NULL;attr=attr->next){
+			if(rco_compiler_get_type(schema, node, attr) != attr_type_filename){
+				continue;
+			}
+
+			if(base_dir == NULL){
+				printf("line %d: %s has a payload, but there is no directory to read it from\n", node->line, node->name);
+				res = -1;
+				break;
+			}
+
+			res = compile_job_list_add(&list, &arena, base_dir, node, attr, opt);
+			if(res < 0){
+				break;
+			}
+		}
+	}
+
+	// The list is complete, so its job pointers stay put from here on
+	nJob = (res >= 0) ? list.nJob : 0;
+
+	for(int i=0;i<nJob;i++){
+		if(thread_pool_submit(pool, compile_job_entry, &(list.jobs[i])) < 0){
+			res = -1;
+		}
+	}
+
+	if(thread_pool_wait(pool) < 0){
+		res = -1;
+	}
+
+	if(res >= 0){
+		res = rco_writer_create(&writer);
+	}
+
+	int job_index = 0;
+
+	for(node=root;node!=NULL && res >= 0;){
+		int nFile = 0;
+
+		elm = rco_writer_add_element(writer, parent, node->name);
+		if(elm == NULL){
+			res = -1;
+			break;
+		}
+
+		for(const XmlAttribute *attr=node->attr;attr!=NULL;attr=attr->next){
+			if(rco_compiler_get_type(schema, node, attr) == attr_type_filename){
+				nFile++;
+			}
+		}
+
+		// Jobs were added in this same order, the first one of the element goes with its origsize
+		const CompileJob *job = (nFile != 0) ? &(list.jobs[job_index]) : NULL;
+		const CompileJob *next_job = job;
+
+		job_index += nFile;
+
+		for(const XmlAttribute *attr=node->attr;attr!=NULL && res >= 0;attr=attr->next){
+			int type = rco_compiler_get_type(schema, node, attr);
+
+			if(type == attr_type_filename){
+				res = rco_compiler_add_attribute(writer, elm, &arena, node, attr, type, next_job++);
+			}else{
+				res = rco_compiler_add_attribute(writer, elm, &arena, node, attr, type, job);
+			}
+		}
+
+		if(node->child != NULL){
+			parent = elm;
+			node = node->child;
+			continue;
+		}
+
+		while(node->next == NULL && node->parent != NULL){
+			node = node->parent;
+			parent = rco_writer_element_get_parent(parent);
+		}
+
+		node = node->next;
+	}
+
+	if(res >= 0){
+		res = rco_writer_finish(writer, magic, ppData, pSize);
+	}
+
+	if(writer != NULL){
+		rco_writer_destroy(writer);
+	}
+
+	for(int i=0;i<list.nJob;i++){
+		free(list.jobs[i].data);
+	}
+
+	free(list.jobs);
+	arena_fini(&arena);
+
+	return res;
+}
+
+int RcoCompiler(const char *xml_path, const char *output_path, const RcoCompilerOption *opt, ThreadPool *pool){
+
+	int res;
+	FileMap map;
+	Arena arena;
+	XmlNode *root;
+	RcoSchema schema;
+	char *base_dir, *schema_path = NULL;
+	void *data = NULL;
+	size_t size = 0;
+
+	res = file_map_open(xml_path, &map);
+	if(res < 0){
+		printf("cannot open \"%s\"\n", xml_path);
+		return res;
+	}
+
+	// Payload paths in the XML are relative to its directory
+	{
+		const char *name = strrchr(xml_path, '/');
+		size_t dir_len = (name != NULL) ? (size_t)(name - xml_path) : 0;
+
+		base_dir = malloc(dir_len + 2);
+		if(base_dir == NULL){
+			file_map_close(&map);
+			return -1;
+		}
+
+		if(name != NULL){
+			memcpy(base_dir, xml_path, dir_len);
+			base_dir[dir_len] = 0;
+		}else{
+			strcpy(base_dir, ".");
+		}
+	}
+
+	if(opt->schema_path == NULL){
+		size_t len = strlen(xml_path);
+
+		if(len > 4 && strcmp(&(xml_path[len - 4]), ".xml") == 0){
+			len -= 4;
+		}
+
+		schema_path = malloc(len + sizeof(".schema"));
+		if(schema_path != NULL){
+			memcpy(schema_path, xml_path, len);
+			strcpy(&(schema_path[len]), ".schema");
+		}
+	}
+
+	arena_init(&arena, 0);
+	rco_schema_init(&schema);
+
+	res = rco_schema_load(&schema, (opt->schema_path != NULL) ? opt->schema_path : schema_path);
+	if(res > 0){
+		if(opt->schema_path != NULL){
+			printf("cannot open \"%s\"\n", opt->schema_path);
+			res = -1;
+		}else{
+			// Without one the types are guessed from the names and values
+			res = 0;
+		}
+	}
+
+	if(res >= 0){
+		res = xml_reader_parse(&arena, map.data, map.size, &root);
+	}
+
+	if(res >= 0){
+		size_t len = strlen(output_path);
+		const char *magic = (len > 4 && strcmp(&(output_path[len - 4]), ".rcs") == 0) ? "RCSF" : "RCOF";
+
+		res = RcoCompiler_core(root, base_dir, &schema, magic, opt, pool, &data, &size);
+	}
+
+	if(res >= 0){
+		res = create_file_with_recursive(output_path, data, size);
+		if(res < 0){
+			printf("cannot write \"%s\"\n", output_path);
+		}
+	}
+
+	free(data);
+	rco_schema_fini(&schema);
+	arena_fini(&arena);
+	free(schema_path);
+	free(base_dir);
+	file_map_close(&map);
+
+	return res;
+}
@@ -0,0 +1,38 @@
+
+#ifndef _RCO_COMPILER_H_
+#define _RCO_COMPILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include "thread_pool.h"
+#include "xml_reader.h"
+#include "rco_schema.h"
+
+
+typedef struct RcoCompilerOption {
+	int level;               // zlib level of compress="on" payloads, 0 for the zlib default
+	const char *schema_path; // NULL for <name>.schema next to the XML
+	int raw_payload;         // compress="on" payload files are already compressed (--raw-payload output)
+} RcoCompilerOption;
+
+/*
+ * Builds an RCOF (or RCSF) image from a decompiled XML tree. Payload paths
+ * are relative to base_dir; they are read and compressed on pool. Locale
+ * sources are compiled from their XML when it is next to the .rcs. schema
+ * may be NULL. *ppData is allocated with malloc and owned by the caller.
+ */
+int RcoCompiler_core(const XmlNode *root, const char *base_dir, const RcoSchema *schema, const char *magic, const RcoCompilerOption *opt, ThreadPool *pool, void **ppData, size_t *pSize);
+
+// Writes an .rcs when output_path ends with .rcs, an .rco otherwise
+int RcoCompiler(const char *xml_path, const char *output_path, const RcoCompilerOption *opt, ThreadPool *pool);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_COMPILER_H_ */
@@ -0,0 +1,1780 @@
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "file_map.h"
+#include "utf16_xml.h"
+#include "rco_inflate.h"
+#include "file_util.h"
+#include "rco_cache.h"
+#include "rco_decompiler.h"
+#include "rco_reader.h"
+
+
+const char *rco_dec_get_string(const void *rco_data, int attr){
+
+	const SceRcoHeader *pHeader;
+
+	pHeader = (const SceRcoHeader *)rco_data;
+
+	return (const char *)(rco_data + pHeader->stringtable_offset + attr);
+}
+
+const SceWChar16 *rco_dec_get_wstring(const void *rco_data, int attr){
+
+	const SceRcoHeader *pHeader;
+
+	pHeader = (const SceRcoHeader *)rco_data;
+
+	return (const SceWChar16 *)(rco_data + pHeader->wstringtable_offset + (attr << 1));
+}
+
+int sce_paf_wcslen(const SceWChar16 *wstr){
+
+	const SceWChar16 *s = wstr;
+
+	while(*wstr != 0){
+		wstr++;
+	}
+
+	return wstr - s;
+}
+
+int search_tag_key_by_name(CXmlTag *cxml, const char *name, CXmlKeyValue **result){
+
+	CXmlKeyValue *kv = cxml->kv;
+
+	while(kv != NULL){
+		if(strcmp(kv->key, name) == 0){
+			*result = kv;
+			return 0;
+		}
+
+		kv = kv->next;
+	}
+
+	return -1;
+}
+
+int search_tag_child_by_name(CXmlTag *cxml, const char *name, CXmlTag **result){
+
+	CXmlTag *child = cxml->child;
+
+	while(child != NULL){
+		if(strcmp(child->name, name) == 0){
+			*result = child;
+			return 0;
+		}
+
+		child = child->next;
+	}
+
+	return -1;
+}
+
+int search_tag_child_by_id(CXmlTag *cxml, int name_id, CXmlTag **result){
+
+	CXmlTag *child = cxml->child;
+
+	while(child != NULL){
+		if(child->name_id == name_id){
+			*result = child;
+			return 0;
+		}
+
+		child = child->next;
+	}
+
+	return -1;
+}
+
+// Index is RCO_NAME_*
+static const char *rco_name_strings[RCO_NAME_MAX] = {
+	NULL, "resource", "stringtable", "locale", "texture", "file", "sounddata", "id", "type", "src", "compress", "origsize"
+};
+
+#define RCO_NAME_UNRESOLVED (0xFF)
+
+int rco_name_cache_init(RcoNameCache *cache, Arena *arena, const void *rco_data){
+
+	const SceRcoHeader *pHeader = (const SceRcoHeader *)rco_data;
+
+	cache->ids  = NULL;
+	cache->size = 0;
+
+	// One byte per stringtable byte, so any handle is a direct index
+	if(pHeader->stringtable_size > 0){
+		cache->ids = arena_alloc(arena, pHeader->stringtable_size);
+		if(cache->ids == NULL){
+			return -1;
+		}
+
+		memset(cache->ids, RCO_NAME_UNRESOLVED, pHeader->stringtable_size);
+		cache->size = pHeader->stringtable_size;
+	}
+
+	return 0;
+}
+
+int rco_name_resolve(RcoNameCache *cache, const void *rco_data, int handle){
+
+	const char *name;
+	int name_id;
+
+	if(handle >= 0 && handle < cache->size && cache->ids[handle] != RCO_NAME_UNRESOLVED){
+		return cache->ids[handle];
+	}
+
+	name = rco_dec_get_string(rco_data, handle);
+	name_id = RCO_NAME_OTHER;
+
+	for(int i=1;i<RCO_NAME_MAX;i++){
+		if(strcmp(name, rco_name_strings[i]) == 0){
+			name_id = i;
+			break;
+		}
+	}
+
+	if(handle >= 0 && handle < cache->size){
+		cache->ids[handle] = name_id;
+	}
+
+	return name_id;
+}
+
+int parse_element_tags(Arena *arena, RcoNameCache *names, const void *rco_data, const void *element, CXmlTag *tag, CXmlKeyValue **result){
+
+	const SceRcoHeader *pHeader = (const SceRcoHeader *)(rco_data);
+	const SceRcoTreeHeader *element_header = (const SceRcoTreeHeader *)(element);
+
+	CXmlKeyValue *head, **tail;
+
+	*result = NULL;
+	tail = result;
+
+	for(int i=0;i<element_header->num_attributes;i++){
+
+		void *base = (void *)(element + sizeof(SceRcoTreeHeader) + 0x10 * i);
+
+		int attrname_handle = *(SceInt32 *)(base + 0);
+		int attr_type = *(SceInt32 *)(base + 4);
+
+		head = arena_alloc(arena, sizeof(*head));
+		if(head == NULL){
+			printf("%s: cannot alloc head\n", __FUNCTION__);
+			return -1;
+		}
+
+		memset(head, 0, sizeof(*head));
+		head->next = NULL;
+		head->tag  = tag;
+		head->key  = NULL;
+
+		*tail = head;
+		tail = &(head->next);
+
+		// Attribute values are views into rco_data, nothing is copied
+		head->key    = rco_dec_get_string(rco_data, attrname_handle);
+		head->key_id = rco_name_resolve(names, rco_data, attrname_handle);
+
+		if(head->key_id >= RCO_NAME_FIRST_KEY && CXML_TAG_KEY(tag, head->key_id) == NULL){
+			CXML_TAG_KEY(tag, head->key_id) = head;
+		}
+
+		head->type = attr_type;
+
+		switch(attr_type){
+		case attr_type_int:
+			head->type_int.data = *(SceInt32 *)(base + 8);
+			break;
+		case attr_type_float:
+			head->type_float.data = *(float *)(base + 8);
+			break;
+		case attr_type_string:
+			{
+				const char *str = rco_dec_get_string(rco_data, *(SceInt32 *)(base + 8));
+
+				head->type_string.data = str;
+				head->type_string.len  = strlen(str);
+			}
+			break;
+		case attr_type_wstring:
+			{
+				const SceWChar16 *wstr = rco_dec_get_wstring(rco_data, *(SceInt32 *)(base + 8));
+
+				head->type_wstring.data = wstr;
+				head->type_wstring.len  = sce_paf_wcslen(wstr);
+			}
+			break;
+		case attr_type_hash:
+			if(*(SceInt32 *)(base + 0xC) != 4){
+				printf("%s: hash attribute with size 0x%X\n", __FUNCTION__, *(SceInt32 *)(base + 0xC));
+				return -1;
+			}
+
+			{
+				SceUInt32 *hashtable = (SceUInt32 *)(rco_data + pHeader->hashtable_offset);
+				head->type_hash.data = hashtable[*(SceInt32 *)(base + 8)];
+			}
+			break;
+		case attr_type_intarray:
+			{
+				SceInt32 *intarraytable = (SceInt32 *)(rco_data + pHeader->intarraytable_offset);
+				int offset = *(SceInt32 *)(base + 8);
+				int size = *(SceInt32 *)(base + 0xC);
+
+				head->type_intarray.data = &(intarraytable[offset]);
+				head->type_intarray.size = size;
+			}
+			break;
+		case attr_type_floatarray:
+			// printf(" %s=\"0x%X, 0x%X\"", rco_dec_get_string(rco_data, attrname_handle), *(SceInt32 *)(base + 8), *(SceInt32 *)(base + 0xC));
+
+			{
+				float *floatarraytable = (float *)(rco_data + pHeader->floatarraytable_offset);
+				int offset = *(SceInt32 *)(base + 8);
+				int size = *(SceInt32 *)(base + 0xC);
+
+				head->type_floatarray.data = &(floatarraytable[offset]);
+				head->type_floatarray.size = size;
+			}
+
+			break;
+		case attr_type_filename:
+			{
+				const void *filetable = (const void *)(rco_data + pHeader->filetable_offset);
+				int offset = *(SceInt32 *)(base + 8);
+				int size = *(SceInt32 *)(base + 0xC);
+
+				head->type_filename.data = filetable + offset;
+				head->type_filename.size = size;
+			}
+			break;
+		case attr_type_id:
+			{
+				const char *id = (const char *)(rco_data + pHeader->idtable_offset + *(SceInt32 *)(base + 8) + 4);
+
+				head->type_id.data = id;
+				head->type_id.len  = strlen(id);
+			}
+			break;
+		case attr_type_idref:
+			// printf(" %s=\"0x%X\"", rco_dec_get_string(rco_data, attrname_handle), *(SceInt32 *)(base + 8));
+			break;
+		case attr_type_idhash:
+			head->type_idhash.data = *(SceUInt32 *)(rco_data + pHeader->idhashtable_offset + *(SceInt32 *)(base + 8) + 4);
+			break;
+		case attr_type_idhashref:
+			head->type_idhashref.data = *(SceUInt32 *)(rco_data + pHeader->idhashtable_offset + *(SceInt32 *)(base + 8) + 4);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+// Checks one element and its attributes the way parse_element_tags reads them
+static int rco_dec_check_element(const RcoReader *reader, int32_t offset){
+
+	const SceRcoTreeHeader *element_header = rco_reader_get_element(reader, offset);
+	const char *str;
+	const void *data;
+	size_t len;
+	SceUInt32 hash;
+
+	if(element_header == NULL || rco_reader_get_string(reader, element_header->name_handle, &str, &len) < 0){
+		return -1;
+	}
+
+	for(int i=0;i<element_header->num_attributes;i++){
+
+		const SceRcoAttribute *attr = rco_reader_get_attribute(reader, offset, i);
+		int res;
+
+		if(rco_reader_get_string(reader, attr->name_handle, &str, &len) < 0){
+			return -1;
+		}
+
+		switch(attr->type){
+		case attr_type_string:
+			res = rco_reader_get_string(reader, attr->v1, &str, &len);
+			break;
+		case attr_type_wstring:
+			res = rco_reader_get_wstring(reader, attr, (const SceWChar16 **)&data, &len);
+			break;
+		case attr_type_hash:
+			res = rco_reader_get_hash(reader, attr, &hash);
+			break;
+		case attr_type_intarray:
+			res = rco_reader_get_intarray(reader, attr, (const SceInt32 **)&data, &len);
+			break;
+		case attr_type_floatarray:
+			res = rco_reader_get_floatarray(reader, attr, (const float **)&data, &len);
+			break;
+		case attr_type_filename:
+			res = rco_reader_get_file(reader, attr, &data, &len);
+			break;
+		case attr_type_id:
+			res = rco_reader_get_id(reader, attr, &str, &len);
+			break;
+		case attr_type_idhash:
+		case attr_type_idhashref:
+			res = rco_reader_get_idhash(reader, attr, &hash);
+			break;
+		default:
+			res = 0;
+			break;
+		}
+
+		if(res < 0){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int rco_dec_check_tree(const RcoReader *reader){
+
+	int32_t offset, *stack = NULL;
+	int nStack = 0, nStackMax = 0;
+	int res = 0;
+
+	offset = rco_reader_get_root(reader);
+	if(offset < 0){
+		return -1;
+	}
+
+	// The same walk as parse_element; the reader only follows links forward, so it ends
+	while(offset >= 0){
+
+		const SceRcoTreeHeader *element_header = rco_reader_get_element(reader, offset);
+
+		res = rco_dec_check_element(reader, offset);
+		if(res < 0){
+			break;
+		}
+
+		if(element_header->first_child_elm_offset != -1){
+			if(rco_reader_get_first_child(reader, offset) != element_header->first_child_elm_offset){
+				res = -1;
+				break;
+			}
+
+			if(nStack == nStackMax){
+				nStackMax = (nStackMax == 0) ? 0x20 : nStackMax * 2;
+
+				int32_t *new_stack = realloc(stack, sizeof(*stack) * nStackMax);
+				if(new_stack == NULL){
+					res = -1;
+					break;
+				}
+
+				stack = new_stack;
+			}
+
+			stack[nStack++] = offset;
+			offset = element_header->first_child_elm_offset;
+			continue;
+		}
+
+		while(element_header->next_elm_offset == -1 && nStack != 0){
+			offset = stack[--nStack];
+			element_header = rco_reader_get_element(reader, offset);
+		}
+
+		if(element_header->next_elm_offset == -1){
+			break;
+		}
+
+		if(rco_reader_get_next_sibling(reader, offset) != element_header->next_elm_offset){
+			res = -1;
+			break;
+		}
+
+		offset = element_header->next_elm_offset;
+	}
+
+	free(stack);
+
+	return res;
+}
+
+int parse_element(Arena *arena, const void *rco_data, const void *element, CXmlTag *parent, CXmlTag **result){
+
+	int res;
+	const SceRcoHeader *pHeader = (const SceRcoHeader *)(rco_data);
+	const SceRcoTreeHeader *element_header;
+	const SceRcoTreeHeader **stack = NULL;
+	int nStack = 0, nStackMax = 0;
+	CXmlTag *cxml, **link;
+	RcoNameCache names;
+
+	/*
+	 * Walk siblings in a loop and only keep the chain of ancestors on an
+	 * explicit stack, so memory grows with the depth but not with the width.
+	 */
+	*result = NULL;
+	link = result;
+
+	res = rco_name_cache_init(&names, arena, rco_data);
+	if(res < 0){
+		return res;
+	}
+
+	while(element != NULL){
+
+		element_header = (const SceRcoTreeHeader *)(element);
+
+		cxml = arena_alloc(arena, sizeof(*cxml));
+		if(cxml == NULL){
+			res = -1;
+			break;
+		}
+
+		memset(cxml, 0, sizeof(*cxml));
+		cxml->parent = parent;
+		cxml->child  = NULL;
+		cxml->next   = NULL;
+		cxml->name   = NULL;
+		cxml->kv     = NULL;
+
+		*link = cxml;
+
+		cxml->name    = rco_dec_get_string(rco_data, element_header->name_handle);
+		cxml->name_id = rco_name_resolve(&names, rco_data, element_header->name_handle);
+
+		if(element_header->first_child_elm_offset == -1 && element_header->last_child_elm_offset == -1){
+
+			res = parse_element_tags(arena, &names, rco_data, element, cxml, &(cxml->kv));
+			if(res < 0){
+				break;
+			}
+
+		}else if(element_header->first_child_elm_offset != -1){
+
+			res = parse_element_tags(arena, &names, rco_data, element, cxml, &(cxml->kv));
+			if(res < 0){
+				break;
+			}
+
+			if(nStack == nStackMax){
+				nStackMax = (nStackMax == 0) ? 0x20 : nStackMax * 2;
+
+				const SceRcoTreeHeader **new_stack = realloc(stack, sizeof(*stack) * nStackMax);
+				if(new_stack == NULL){
+					res = -1;
+					break;
+				}
+
+				stack = new_stack;
+			}
+
+			stack[nStack++] = element_header;
+
+			parent  = cxml;
+			link    = &(cxml->child);
+			element = rco_data + pHeader->tree_offset + element_header->first_child_elm_offset;
+			continue;
+		}
+
+		link = &(cxml->next);
+
+		// Climb up until an ancestor has a next sibling
+		while(element_header->next_elm_offset == -1 && nStack != 0){
+			element_header = stack[--nStack];
+			cxml   = parent;
+			parent = cxml->parent;
+			link   = &(cxml->next);
+		}
+
+		if(element_header->next_elm_offset != -1){
+			element = rco_data + pHeader->tree_offset + element_header->next_elm_offset;
+		}else{
+			element = NULL;
+		}
+	}
+
+	free(stack);
+
+	return res;
+}
+
+struct PayloadJob {
+	const char *path;
+	const char *xml_name; // Set for locale RCS payloads
+	const void *data;
+	int size;
+	int origsize; // -1 if the data is not compressed
+	int flags;
+	struct PayloadJob *original; // Set if this is a duplicate of another payload
+	struct PayloadJob *next_duplicate;
+	RcoStats *stats;
+};
+
+int payload_job_locale(PayloadJob *job, const void *data, int size){
+
+	int res;
+	Arena arena;
+	RcoDecompilerContext ctx;
+
+	res = create_parent_directory(job->xml_name);
+	if(res < 0){
+		return res;
+	}
+
+	// Runs on a worker, so it cannot share the arena or wait on the pool
+	arena_init(&arena, 0);
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.arena = &arena;
+	ctx.pool  = NULL;
+	ctx.flags = job->flags;
+	ctx.stats = job->stats;
+
+	uint64_t start = rco_stats_start(job->stats);
+
+	res = RcsDecompiler_core(job->xml_name, data, size, &ctx);
+	if(res < 0){
+		printf("failed to decompile \"%s\"\n", job->path);
+	}
+
+	rco_stats_add_time(job->stats, RCO_STATS_TIME_LOCALE, start);
+
+	arena_fini(&arena);
+
+	return res;
+}
+
+int payload_job_inflate_to_file(PayloadJob *job){
+
+	int res;
+	size_t written = 0;
+	FILE *fp;
+
+	res = create_parent_directory(job->path);
+	if(res < 0){
+		return res;
+	}
+
+	fp = create_output_file(job->path);
+	if(fp == NULL){
+		return -1;
+	}
+
+	uint64_t start = rco_stats_start(job->stats);
+
+	// Bounded memory: large payloads are inflated and written chunk by chunk
+	res = rco_inflate_to_file(fp, job->data, job->size, job->origsize, &written);
+	if(res < 0){
+		printf("cannot inflate \"%s\"\n", job->path);
+	}else if(written != (size_t)job->origsize){
+		printf("warning: %s inflated to 0x%zX bytes, origsize is 0x%X\n", job->path, written, job->origsize);
+	}
+
+	fclose(fp);
+
+	rco_stats_add_time(job->stats, RCO_STATS_TIME_INFLATE_STREAM, start);
+	rco_stats_add_count(job->stats, RCO_STATS_FILES_WRITTEN, 1);
+	rco_stats_add_count(job->stats, RCO_STATS_PAYLOAD_BYTES_OUT, written);
+
+	return res;
+}
+
+int payload_job_entry(void *argp){
+
+	int res;
+	PayloadJob *job = (PayloadJob *)argp;
+	const void *data = job->data;
+	int size = job->size;
+	const void *rcs_data = job->data;
+	int rcs_size = job->size;
+	void *temp_memory_ptr = NULL;
+	int is_raw = (job->flags & RCO_DEC_FLAG_RAW_PAYLOAD) != 0;
+
+	if(job->origsize >= 0 && job->xml_name == NULL && is_raw == 0){
+		return payload_job_inflate_to_file(job);
+	}
+
+	// A locale has to be in memory as a whole to be decompiled
+	if(job->origsize >= 0 && job->xml_name != NULL){
+		size_t temp_size = job->origsize;
+
+		temp_memory_ptr = malloc(temp_size);
+		if(temp_memory_ptr == NULL){
+			return -1;
+		}
+
+		uint64_t start = rco_stats_start(job->stats);
+
+		res = rco_inflate_buffer(temp_memory_ptr, &temp_size, job->data, job->size);
+
+		rco_stats_add_time(job->stats, RCO_STATS_TIME_INFLATE, start);
+
+		if(res < 0){
+			printf("cannot inflate \"%s\"\n", job->path);
+			free(temp_memory_ptr);
+			return -1;
+		}
+
+		rcs_data = temp_memory_ptr;
+		rcs_size = temp_size;
+
+		// In raw mode the .rcs keeps the stored bytes, only its XML needs them inflated
+		if(is_raw == 0){
+			data = rcs_data;
+			size = rcs_size;
+		}
+	}
+
+	res = 0;
+
+	if(job->xml_name == NULL || (job->flags & RCO_DEC_FLAG_NO_RCS) == 0){
+		uint64_t start = rco_stats_start(job->stats);
+
+		res = create_file_with_recursive(job->path, data, size);
+
+		rco_stats_add_time(job->stats, RCO_STATS_TIME_WRITE, start);
+		rco_stats_add_count(job->stats, RCO_STATS_FILES_WRITTEN, 1);
+		rco_stats_add_count(job->stats, RCO_STATS_PAYLOAD_BYTES_OUT, size);
+	}
+
+	// Locale RCS is decompiled straight from memory, not read back from disk
+	if(res >= 0 && job->xml_name != NULL){
+		res = payload_job_locale(job, rcs_data, rcs_size);
+	}
+
+	free(temp_memory_ptr);
+	temp_memory_ptr = NULL;
+
+	return res;
+}
+
+int payload_match_location(const void *value, const void *key){
+
+	const PayloadJob *a = (const PayloadJob *)value;
+	const PayloadJob *b = (const PayloadJob *)key;
+
+	return a->data == b->data && a->size == b->size && a->origsize == b->origsize;
+}
+
+int payload_match_content(const void *value, const void *key){
+
+	const PayloadJob *a = (const PayloadJob *)value;
+	const PayloadJob *b = (const PayloadJob *)key;
+
+	return a->size == b->size && a->origsize == b->origsize && memcmp(a->data, b->data, a->size) == 0;
+}
+
+/*
+ * Returns the first payload with the same filetable entry or the same bytes,
+ * or registers job as a new one and returns NULL.
+ */
+PayloadJob *payload_index_lookup(HashTable *index, PayloadJob *job){
+
+	uint64_t location_hash, content_hash;
+	PayloadJob *original;
+
+	location_hash = hash_table_hash_u64((uint64_t)(uintptr_t)job->data ^ ((uint64_t)job->size << 32));
+
+	original = hash_table_find(index, location_hash, payload_match_location, job);
+	if(original != NULL){
+		return original;
+	}
+
+	content_hash = hash_table_hash_bytes(job->data, job->size, (uint64_t)(uint32_t)job->origsize);
+
+	original = hash_table_find(index, content_hash, payload_match_content, job);
+	if(original != NULL){
+		return original;
+	}
+
+	hash_table_insert(index, location_hash, job);
+	hash_table_insert(index, content_hash, job);
+
+	return NULL;
+}
+
+int payload_link_duplicates(RcoDecompilerContext *ctx){
+
+	int res = 0;
+	PayloadJob *job = ctx->duplicates;
+	uint64_t start = rco_stats_start(ctx->stats);
+
+	while(job != NULL){
+		if(strcmp(job->path, job->original->path) != 0){
+			if(link_or_copy_file(job->original->path, job->path) < 0){
+				printf("cannot link \"%s\"\n", job->path);
+				res = -1;
+			}
+
+			rco_stats_add_count(ctx->stats, RCO_STATS_FILES_LINKED, 1);
+		}
+
+		job = job->next_duplicate;
+	}
+
+	rco_stats_add_time(ctx->stats, RCO_STATS_TIME_WRITE, start);
+
+	ctx->duplicates = NULL;
+
+	return res;
+}
+
+/*
+ * Builds the job that writes the payload of a filename attribute. *ppJob is
+ * left NULL for elements whose payloads are not extracted.
+ */
+int payload_job_create(RcoDecompilerContext *ctx, CXmlKeyValue *kv, PayloadJob **ppJob){
+
+	PayloadJob *job;
+
+	*ppJob = NULL;
+
+	char src_path[0x200];
+	CXmlTag *tag = kv->tag;
+
+	if(tag->name_id == RCO_NAME_LOCALE){
+		CXmlKeyValue *kv_id = CXML_TAG_KEY(tag, RCO_NAME_ID);
+		snprintf(src_path, sizeof(src_path), "%s/locale/plugin_locale_%s.xml.rcs", ctx->output_path, kv_id->type_id.data);
+	}else if(tag->name_id == RCO_NAME_TEXTURE || tag->name_id == RCO_NAME_FILE || tag->name_id == RCO_NAME_SOUNDDATA){
+		CXmlKeyValue *kv_id   = CXML_TAG_KEY(tag, RCO_NAME_ID);
+		CXmlKeyValue *kv_type = CXML_TAG_KEY(tag, RCO_NAME_TYPE);
+
+		const char *type = kv_type->type_string.data;
+
+		const char *part = strchr(type, '/');
+		if(part != NULL){
+			char *new_name = malloc((part - type) + 1);
+			if(new_name == NULL){
+				return -1;
+			}
+
+			new_name[part - type] = 0;
+			memcpy(new_name, type, part - type);
+			snprintf(src_path, sizeof(src_path), "%s/%s/%s_0x%08X.%s", ctx->output_path, tag->name, new_name, kv_id->type_int.data, &(part[1]));
+			free(new_name);
+			new_name = NULL;
+		}else{
+			snprintf(src_path, sizeof(src_path), "%s/%s/%s_0x%08X.tex", ctx->output_path, tag->name, tag->name, kv_id->type_int.data);
+		}
+
+	}else{
+		src_path[0] = 0;
+	}
+
+	if(src_path[0] == 0){
+		return 0;
+	}
+
+	job = arena_alloc(ctx->arena, sizeof(*job));
+	if(job == NULL){
+		return -1;
+	}
+
+	memset(job, 0, sizeof(*job));
+
+	job->path     = arena_strndup(ctx->arena, src_path, strlen(src_path));
+	job->data     = kv->type_filename.data;
+	job->size     = kv->type_filename.size;
+	job->origsize = -1;
+	job->flags    = ctx->flags;
+	job->stats    = ctx->stats;
+
+	if(tag->name_id == RCO_NAME_LOCALE){
+		char xml_name[0x200];
+		snprintf(xml_name, sizeof(xml_name), "%.*s%s", (int)(strlen(src_path) - strlen(".xml.rcs")), src_path, rco_dec_format_extension(ctx->flags));
+
+		job->xml_name = arena_strndup(ctx->arena, xml_name, strlen(xml_name));
+		if(job->xml_name == NULL){
+			return -1;
+		}
+	}
+
+	if(job->path == NULL){
+		return -1;
+	}
+
+	CXmlKeyValue *kv_compress = CXML_TAG_KEY(tag, RCO_NAME_COMPRESS);
+
+	if(kv_compress != NULL && strcmp(kv_compress->type_string.data, "on") == 0){
+
+		CXmlKeyValue *kv_origsize = CXML_TAG_KEY(tag, RCO_NAME_ORIGSIZE);
+
+		if(kv_origsize == NULL){
+			printf("%s: compressed %s has no origsize\n", __FUNCTION__, tag->name);
+			return -1;
+		}
+
+		job->origsize = kv_origsize->type_int.data;
+	}
+
+	*ppJob = job;
+
+	return 0;
+}
+
+/*
+ * Queues the payload of a filename attribute and gives its path relative to
+ * the output directory, or NULL for elements whose payloads are not extracted.
+ */
+int payload_job_submit(RcoDecompilerContext *ctx, CXmlKeyValue *kv, const char **pPath){
+
+	int res;
+	PayloadJob *job;
+
+	*pPath = NULL;
+
+	res = payload_job_create(ctx, kv, &job);
+	if(res < 0){
+		return res;
+	}
+
+	if(job == NULL){
+		return 0;
+	}
+
+	if(job->xml_name == NULL && ctx->payload_index != NULL){
+		job->original = payload_index_lookup(ctx->payload_index, job);
+	}
+
+	if((ctx->flags & RCO_DEC_FLAG_NO_PAYLOAD) == 0){
+		rco_stats_add_count(ctx->stats, RCO_STATS_PAYLOADS, 1);
+		rco_stats_add_count(ctx->stats, RCO_STATS_PAYLOAD_BYTES_IN, job->size);
+	}
+
+	if((ctx->flags & RCO_DEC_FLAG_NO_PAYLOAD) != 0){
+		// Only the XML is wanted
+	}else if(job->original != NULL){
+		job->next_duplicate = ctx->duplicates;
+		ctx->duplicates = job;
+	}else if(ctx->writer != NULL && job->xml_name == NULL && (job->origsize < 0 || (ctx->flags & RCO_DEC_FLAG_RAW_PAYLOAD) != 0)){
+		// Nothing to inflate, so no worker either: the bytes go from the input straight into a batch
+		res = file_writer_add(ctx->writer, job->path, job->data, job->size);
+		if(res < 0){
+			return res;
+		}
+	}else{
+		// The file is written by a worker while the XML goes on
+		res = thread_pool_submit(ctx->pool, payload_job_entry, job);
+		if(res < 0){
+			return res;
+		}
+	}
+
+	kv->type_filename.output = job->path;
+
+	*pPath = job->path + strlen(ctx->output_path) + 1;
+
+	return 0;
+}
+
+int print_cxml_tags(RcoDecompilerContext *ctx, OutBuffer *out, CXmlKeyValue *kv){
+
+	int res;
+
+	while(kv != NULL){
+
+		out_buffer_putc(out, ' ');
+		out_buffer_puts(out, kv->key);
+		out_buffer_write(out, "=\"", 2);
+
+		switch(kv->type){
+		case attr_type_int:
+			out_buffer_print_int(out, kv->type_int.data);
+			break;
+		case attr_type_float:
+			{
+				float tmp;
+				if(modff(kv->type_float.data, &tmp) == 0.0f){
+					// printf("%.0f", kv->type_float.data);
+				}else{
+					// printf("%f", kv->type_float.data);
+				}
+
+				out_buffer_print_float_exact(out, kv->type_float.data);
+			}
+
+			break;
+		case attr_type_string:
+			out_buffer_write(out, kv->type_string.data, kv->type_string.len);
+			break;
+		case attr_type_wstring:
+			utf16_print_xml(out, kv->type_wstring.data, kv->type_wstring.len);
+			break;
+		case attr_type_hash:
+			out_buffer_print_hex32(out, kv->type_hash.data);
+			break;
+		case attr_type_intarray:
+			{
+				if(kv->type_intarray.size != 0){
+					out_buffer_print_int(out, kv->type_intarray.data[0]);
+					for(int i=1;i<kv->type_intarray.size;i++){
+						out_buffer_write(out, ", ", 2);
+						out_buffer_print_int(out, kv->type_intarray.data[i]);
+					}
+				}
+			}
+			break;
+		case attr_type_floatarray:
+			{
+				if(kv->type_floatarray.size != 0){
+					float tmp;
+					if(modff(kv->type_floatarray.data[0], &tmp) == 0.0f){
+						// printf("%.0f", kv->type_floatarray.data[0]);
+					}else{
+						// printf("%f", kv->type_floatarray.data[0]);
+					}
+
+					out_buffer_print_float_exact(out, kv->type_floatarray.data[0]);
+
+					for(int i=1;i<kv->type_floatarray.size;i++){
+						if(modff(kv->type_floatarray.data[i], &tmp) == 0.0f){
+							// printf(", %.0f", kv->type_floatarray.data[i]);
+						}else{
+							// printf(", %f", kv->type_floatarray.data[i]);
+						}
+
+						out_buffer_write(out, ", ", 2);
+						out_buffer_print_float_exact(out, kv->type_floatarray.data[i]);
+					}
+				}
+			}
+
+			break;
+		case attr_type_filename:
+			{
+				const char *path;
+
+				res = payload_job_submit(ctx, kv, &path);
+				if(res < 0){
+					return res;
+				}
+
+				if(path != NULL){
+					out_buffer_puts(out, path);
+				}
+			}
+			break;
+		case attr_type_id:
+			out_buffer_write(out, kv->type_id.data, kv->type_id.len);
+			break;
+		case attr_type_idref:
+			// TODO
+			break;
+		case attr_type_idhash:
+			out_buffer_print_hex32(out, kv->type_idhash.data);
+			break;
+		case attr_type_idhashref:
+			out_buffer_print_hex32(out, kv->type_idhashref.data);
+			break;
+		default:
+			break;
+		}
+
+		out_buffer_putc(out, '"');
+
+		kv = kv->next;
+	}
+
+	return 0;
+}
+
+const char *rco_dec_format_extension(int flags){
+
+	switch(flags & RCO_DEC_FORMAT_MASK){
+	case RCO_DEC_FORMAT_JSON:
+		return ".jsonl";
+	case RCO_DEC_FORMAT_BIN:
+		return ".bin";
+	default:
+		return ".xml";
+	}
+}
+
+// Counts one element for the stats and adds its attribute types to the schema
+int print_cxml_record(RcoDecompilerContext *ctx, CXmlTag *cxml, uint64_t *attr_type){
+
+	if(ctx->stats != NULL){
+		for(CXmlKeyValue *kv=cxml->kv;kv!=NULL;kv=kv->next){
+			if(kv->type > 0 && kv->type < RCO_STATS_ATTR_TYPE_MAX){
+				attr_type[kv->type]++;
+			}
+		}
+	}
+
+	if(ctx->schema != NULL){
+		for(CXmlKeyValue *kv=cxml->kv;kv!=NULL;kv=kv->next){
+			if(rco_schema_set(ctx->schema, cxml->name, kv->key, kv->type) < 0){
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void print_cxml_record_fini(RcoDecompilerContext *ctx, uint64_t nElement, const uint64_t *attr_type){
+
+	if(ctx->stats != NULL){
+		uint64_t nAttribute = 0;
+
+		for(int i=0;i<RCO_STATS_ATTR_TYPE_MAX;i++){
+			rco_stats_add_attr_type(ctx->stats, i, attr_type[i]);
+			nAttribute += attr_type[i];
+		}
+
+		rco_stats_add_count(ctx->stats, RCO_STATS_ELEMENTS, nElement);
+		rco_stats_add_count(ctx->stats, RCO_STATS_ATTRIBUTES, nAttribute);
+	}
+}
+
+int print_cxml(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml, int level){
+
+	int res;
+	int base_level = level;
+	uint64_t nElement = 0, attr_type[RCO_STATS_ATTR_TYPE_MAX];
+
+	memset(attr_type, 0, sizeof(attr_type));
+
+	// The tree keeps parent links, so no stack is needed to come back up
+	while(cxml != NULL){
+
+		nElement++;
+
+		res = print_cxml_record(ctx, cxml, attr_type);
+		if(res < 0){
+			return res;
+		}
+
+		out_buffer_print_indent(out, level);
+		out_buffer_putc(out, '<');
+		out_buffer_puts(out, cxml->name);
+
+		res = print_cxml_tags(ctx, out, cxml->kv);
+		if(res < 0){
+			return res;
+		}
+
+		if(cxml->child != NULL){
+			out_buffer_write(out, ">\n", 2);
+
+			cxml = cxml->child;
+			level++;
+			continue;
+		}
+
+		out_buffer_write(out, " />\n", 4);
+
+		while(cxml->next == NULL && level > base_level){
+			cxml = cxml->parent;
+			level--;
+
+			out_buffer_print_indent(out, level);
+			out_buffer_write(out, "</", 2);
+			out_buffer_puts(out, cxml->name);
+			out_buffer_write(out, ">\n", 2);
+		}
+
+		cxml = cxml->next;
+	}
+
+	print_cxml_record_fini(ctx, nElement, attr_type);
+
+	return 0;
+}
+
+// Writes the whole tree in the format selected by ctx->flags
+int print_cxml_document(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml){
+
+	switch(ctx->flags & RCO_DEC_FORMAT_MASK){
+	case RCO_DEC_FORMAT_JSON:
+		return print_cxml_json(ctx, out, cxml);
+	case RCO_DEC_FORMAT_BIN:
+		return print_cxml_bin(ctx, out, cxml);
+	default:
+		out_buffer_puts(out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
+		// out_buffer_puts(out, "<?xml version=\"1.0\" encoding=\"unicode\"?>\n");
+		return print_cxml(ctx, out, cxml, 0);
+	}
+}
+
+int RcsDecompiler_core(const char *xml_name, const void *rcs_data, int rcs_size, RcoDecompilerContext *ctx){
+
+	int res;
+	const SceRcoHeader *pHeader;
+	CXmlTag *result;
+	FILE *xml_fp;
+	OutBuffer out;
+
+	pHeader = (const SceRcoHeader *)rcs_data;
+
+	if(rcs_size < (int)sizeof(SceRcoHeader)){
+		printf("Input too small (0x%X bytes)\n", rcs_size);
+		return -1;
+	}
+
+	if(memcmp(pHeader->magic, "RCSF", 4) != 0){
+		printf("Header bad magic (%02X %02X %02X %02X)\n", pHeader->magic[0], pHeader->magic[1], pHeader->magic[2], pHeader->magic[3]);
+		return -1;
+	}
+
+	xml_fp = create_output_file(xml_name);
+	if(xml_fp == NULL){
+		return -1;
+	}
+
+	rco_stats_add_count(ctx->stats, RCO_STATS_FILES_WRITTEN, 1);
+
+	res = out_buffer_init(&out, xml_fp, 0);
+	if(res < 0){
+		fclose(xml_fp);
+		return res;
+	}
+
+	RcoDecompilerContext rcs_ctx = *ctx;
+	rcs_ctx.output_path = "NULL";
+
+	res = parse_element(ctx->arena, rcs_data, (const void *)(rcs_data + pHeader->tree_offset), NULL, &result);
+	if(res >= 0){
+		res = print_cxml_document(&rcs_ctx, &out, result);
+	}
+
+	if(thread_pool_wait(ctx->pool) < 0 && res >= 0){
+		res = -1;
+	}
+
+	arena_reset(ctx->arena);
+	result = NULL;
+
+	if(out_buffer_fini(&out) < 0 && res >= 0){
+		printf("cannot write \"%s\"\n", xml_name);
+		res = -1;
+	}
+
+	fclose(xml_fp);
+	xml_fp = NULL;
+
+	return res;
+}
+
+int RcsDecompiler(const char *xml_name, const char *path, RcoDecompilerContext *ctx){
+
+	int res;
+	FileMap map;
+
+	res = file_map_open(path, &map);
+	if(res < 0){
+		return res;
+	}
+
+	res = RcsDecompiler_core(xml_name, map.data, map.size, ctx);
+
+	file_map_close(&map);
+
+	return res;
+}
+
+int process_stringtable(CXmlTag *root){
+
+	CXmlTag *cxml_stringtable_tag = NULL;
+
+	search_tag_child_by_id(root, RCO_NAME_STRINGTABLE, &cxml_stringtable_tag);
+
+	if(cxml_stringtable_tag != NULL){
+		printf("Found %s in %s\n", cxml_stringtable_tag->name, cxml_stringtable_tag->parent->name);
+
+		CXmlTag *locale_link = cxml_stringtable_tag->child;
+		while(locale_link != NULL){
+			// printf("%s\n", locale_link->name);
+
+			if(locale_link->name_id == RCO_NAME_LOCALE){
+
+				CXmlKeyValue *kv_src = CXML_TAG_KEY(locale_link, RCO_NAME_SRC);
+
+				printf("%s\n", kv_src->type_filename.output);
+			}
+			locale_link = locale_link->next;
+		}
+	}
+
+	return 0;
+}
+
+int RcoDecompiler_core(const char *plugin_name, const void *rco_data, int rco_size, RcoDecompilerContext *ctx){
+	return RcoDecompiler_core_into(plugin_name, plugin_name, rco_data, rco_size, ctx);
+}
+
+int RcoDecompiler_core_into(const char *output_dir, const char *plugin_name, const void *rco_data, int rco_size, RcoDecompilerContext *ctx){
+
+	int res;
+	const SceRcoHeader *pHeader;
+	CXmlTag *result;
+	char xml_name[0x200];
+	FILE *xml_fp;
+	OutBuffer out;
+	HashTable payload_index;
+	FileWriter writer;
+
+
+	pHeader = (const SceRcoHeader *)rco_data;
+
+	if(rco_size < (int)sizeof(SceRcoHeader)){
+		printf("Input too small (0x%X bytes)\n", rco_size);
+		return -1;
+	}
+
+	if(memcmp(pHeader->magic, "RCOF", 4) != 0){
+		printf("Header bad magic (%02X %02X %02X %02X)\n", pHeader->magic[0], pHeader->magic[1], pHeader->magic[2], pHeader->magic[3]);
+		return -1;
+	}
+
+	snprintf(xml_name, sizeof(xml_name), "%s/", output_dir);
+
+	res = create_file_with_recursive(xml_name, NULL, 0);
+	if(res < 0){
+		return res;
+	}
+
+	snprintf(xml_name, sizeof(xml_name), "%s/%s%s", output_dir, plugin_name, rco_dec_format_extension(ctx->flags));
+
+
+	xml_fp = create_output_file(xml_name);
+	if(xml_fp == NULL){
+		return -1;
+	}
+
+	rco_stats_add_count(ctx->stats, RCO_STATS_FILES_WRITTEN, 1);
+
+	res = out_buffer_init(&out, xml_fp, 0);
+	if(res < 0){
+		fclose(xml_fp);
+		return res;
+	}
+
+	ctx->output_path = output_dir;
+	ctx->duplicates  = NULL;
+
+	if((ctx->flags & RCO_DEC_FLAG_NO_DEDUP) == 0 && hash_table_init(&payload_index, 0x100) >= 0){
+		ctx->payload_index = &payload_index;
+	}
+
+	if((ctx->flags & RCO_DEC_FLAG_NO_PAYLOAD) == 0 && file_writer_init(&writer, 0, ctx->stats) >= 0){
+		ctx->writer = &writer;
+	}
+
+	uint64_t start = rco_stats_start(ctx->stats);
+
+	res = parse_element(ctx->arena, rco_data, (const void *)(rco_data + pHeader->tree_offset), NULL, &result);
+
+	rco_stats_add_time(ctx->stats, RCO_STATS_TIME_PARSE, start);
+
+	RcoSchema schema;
+
+	if((ctx->flags & RCO_DEC_FLAG_SCHEMA) != 0 && rco_schema_init(&schema) >= 0){
+		ctx->schema = &schema;
+	}
+
+	if(res >= 0){
+		start = rco_stats_start(ctx->stats);
+		res = print_cxml_document(ctx, &out, result);
+		rco_stats_add_time(ctx->stats, RCO_STATS_TIME_PRINT, start);
+	}
+
+	if(ctx->schema != NULL){
+		if(res >= 0){
+			char schema_name[0x200];
+			snprintf(schema_name, sizeof(schema_name), "%s/%s.schema", output_dir, plugin_name);
+
+			if(schema.nConflict != 0){
+				printf("warning: %d attributes change type within one element name, the schema keeps the first\n", schema.nConflict);
+			}
+
+			if(rco_schema_save(&schema, schema_name) < 0){
+				printf("cannot write \"%s\"\n", schema_name);
+				res = -1;
+			}
+		}
+
+		rco_schema_fini(&schema);
+		ctx->schema = NULL;
+	}
+
+	// TODO: Properly handle it here instead of inside print_cxml.
+	// process_stringtable(result);
+
+	// Paths are in the arena and the data in the input, both valid until here
+	if(ctx->writer != NULL){
+		if(file_writer_fini(ctx->writer) < 0 && res >= 0){
+			res = -1;
+		}
+
+		ctx->writer = NULL;
+	}
+
+	start = rco_stats_start(ctx->stats);
+
+	// Payload jobs, including the locale RCS, still refer to the arena
+	if(thread_pool_wait(ctx->pool) < 0 && res >= 0){
+		res = -1;
+	}
+
+	rco_stats_add_time(ctx->stats, RCO_STATS_TIME_WAIT, start);
+
+	if(payload_link_duplicates(ctx) < 0 && res >= 0){
+		res = -1;
+	}
+
+	if(ctx->payload_index != NULL){
+		hash_table_fini(ctx->payload_index);
+		ctx->payload_index = NULL;
+	}
+
+	// The whole tree lives in the arena
+	arena_reset(ctx->arena);
+	result = NULL;
+
+	if(out_buffer_fini(&out) < 0 && res >= 0){
+		printf("cannot write \"%s\"\n", xml_name);
+		res = -1;
+	}
+
+	fclose(xml_fp);
+	xml_fp = NULL;
+
+	return res;
+}
+
+int RcoDecompiler_cached(const char *plugin_name, const void *rco_data, int rco_size, RcoDecompilerContext *ctx, const char *cache_dir){
+
+	int res;
+	char key[RCO_CACHE_KEY_SIZE];
+	char temp_dir[0x100];
+
+	rco_cache_make_key(key, rco_data, rco_size, plugin_name, ctx->flags);
+
+	res = rco_cache_restore(cache_dir, key, plugin_name);
+	if(res == 0){
+		if(ctx->stats != NULL){
+			ctx->stats->cached = 1;
+		}
+
+		return 0;
+	}
+
+	if(res < 0){
+		printf("cache: cannot restore %s, decompiling again\n", key);
+	}
+
+	// The output directory may hold files of earlier runs, so only what this run writes is stored
+	rco_cache_make_temp_name(temp_dir, sizeof(temp_dir), plugin_name);
+
+	res = RcoDecompiler_core_into(temp_dir, plugin_name, rco_data, rco_size, ctx);
+	if(res >= 0){
+		res = rco_cache_publish(cache_dir, key, temp_dir, plugin_name);
+		if(res < 0){
+			printf("cache: cannot move the result to \"%s\"\n", plugin_name);
+		}
+	}else{
+		rco_cache_discard(temp_dir);
+	}
+
+	return res;
+}
+
+// The output directory is the file name without its directory and extension
+char *rco_dec_make_plugin_name(const char *path){
+
+	char *plugin_name;
+	const char *name = strrchr(path, '/');
+	if(name != NULL){
+		name = &(name[1]);
+	}else{
+		name = path;
+	}
+
+	const char *name_c = strrchr(name, '.');
+	int name_len = (name_c != NULL) ? (name_c - name) : (int)strlen(name);
+
+	plugin_name = malloc(name_len + 1);
+	if(plugin_name == NULL){
+		return NULL;
+	}
+
+	plugin_name[name_len] = 0;
+	memcpy(plugin_name, name, name_len);
+
+	return plugin_name;
+}
+
+int RcoDecompiler(const char *path, const RcoDecompilerOption *opt, Arena *arena, ThreadPool *pool){
+
+	int res;
+	FileMap map;
+	Arena local_arena;
+	RcoDecompilerContext ctx;
+	RcoStats stats, *pStats = NULL;
+	uint64_t start;
+	char *plugin_name;
+
+	if(opt->stats_fp != NULL){
+		memset(&stats, 0, sizeof(stats));
+		pStats = &stats;
+	}
+
+	start = rco_stats_start(pStats);
+
+	res = file_map_open(path, &map);
+
+	rco_stats_add_time(pStats, RCO_STATS_TIME_READ, start);
+
+	if(res < 0){
+		if(pStats != NULL){
+			rco_stats_add_time(pStats, RCO_STATS_TIME_TOTAL, start);
+			rco_stats_write_json(opt->stats_fp, path, res, pStats);
+		}
+
+		return res;
+	}
+
+	plugin_name = rco_dec_make_plugin_name(path);
+	if(plugin_name == NULL){
+		file_map_close(&map);
+		return -1;
+	}
+
+	if(arena == NULL){
+		arena_init(&local_arena, 0);
+		arena = &local_arena;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.arena = arena;
+	ctx.pool  = pool;
+	ctx.flags = opt->flags;
+	ctx.stats = pStats;
+
+	if(opt->cache_dir != NULL){
+		res = RcoDecompiler_cached(plugin_name, map.data, map.size, &ctx, opt->cache_dir);
+	}else{
+		res = RcoDecompiler_core(plugin_name, map.data, map.size, &ctx);
+	}
+
+	if(arena == &local_arena){
+		arena_fini(arena);
+	}else{
+		arena_reset(arena);
+	}
+
+	free(plugin_name);
+	plugin_name = NULL;
+
+	file_map_close(&map);
+
+	if(pStats != NULL){
+		rco_stats_add_time(pStats, RCO_STATS_TIME_TOTAL, start);
+		rco_stats_write_json(opt->stats_fp, path, res, pStats);
+	}
+
+	return res;
+}
+
+/*
+ * Checks the raw attributes of one element against the query without
+ * building a tag. Returns 1 if an id or idhash attribute matches and the
+ * element has a payload, 0 otherwise and -1 if an attribute is out of range.
+ */
+static int rco_extract_match(const RcoReader *reader, int32_t offset, const char *query, int is_hash, SceUInt32 hash){
+
+	const SceRcoTreeHeader *element_header = rco_reader_get_element(reader, offset);
+	int is_match = 0, has_payload = 0;
+
+	for(int i=0;i<element_header->num_attributes;i++){
+
+		const SceRcoAttribute *attr = rco_reader_get_attribute(reader, offset, i);
+
+		if(attr->type == attr_type_filename){
+			has_payload = 1;
+		}else if(attr->type == attr_type_id && is_hash == 0){
+			const char *id;
+			size_t len;
+
+			if(rco_reader_get_id(reader, attr, &id, &len) < 0){
+				return -1;
+			}
+
+			if(len == strlen(query) && memcmp(id, query, len) == 0){
+				is_match = 1;
+			}
+		}else if(attr->type == attr_type_idhash && is_hash != 0){
+			SceUInt32 value;
+
+			if(rco_reader_get_idhash(reader, attr, &value) < 0){
+				return -1;
+			}
+
+			if(value == hash){
+				is_match = 1;
+			}
+		}
+	}
+
+	return is_match != 0 && has_payload != 0;
+}
+
+/*
+ * Decodes the element found by RcoExtract_core through the reader, so every
+ * value payload_job_create uses is range checked. Only the attribute types it
+ * reads are kept, and a well-known name only gets its slot with the type
+ * payload_job_create expects.
+ */
+static int rco_extract_decode(Arena *arena, RcoNameCache *names, const RcoReader *reader, int32_t offset, CXmlTag *tag){
+
+	const SceRcoTreeHeader *element_header = rco_reader_get_element(reader, offset);
+	CXmlKeyValue **tail = &(tag->kv);
+	size_t len;
+	int res;
+
+	if(rco_reader_get_string(reader, element_header->name_handle, &(tag->name), &len) < 0){
+		return -1;
+	}
+
+	tag->name_id = rco_name_resolve(names, reader->data, element_header->name_handle);
+
+	for(int i=0;i<element_header->num_attributes;i++){
+
+		const SceRcoAttribute *attr = rco_reader_get_attribute(reader, offset, i);
+		CXmlKeyValue kv;
+		int slot_type;
+
+		memset(&kv, 0, sizeof(kv));
+		kv.tag  = tag;
+		kv.type = attr->type;
+
+		if(rco_reader_get_string(reader, attr->name_handle, &(kv.key), &len) < 0){
+			return -1;
+		}
+
+		kv.key_id = rco_name_resolve(names, reader->data, attr->name_handle);
+
+		switch(attr->type){
+		case attr_type_int:
+			kv.type_int.data = attr->v1;
+			res = 0;
+			break;
+		case attr_type_string:
+			res = rco_reader_get_string(reader, attr->v1, &(kv.type_string.data), &len);
+			kv.type_string.len = len;
+			break;
+		case attr_type_filename:
+			res = rco_reader_get_file(reader, attr, &(kv.type_filename.data), &len);
+			kv.type_filename.size = len;
+			break;
+		case attr_type_id:
+			res = rco_reader_get_id(reader, attr, &(kv.type_id.data), &len);
+			kv.type_id.len = len;
+			break;
+		case attr_type_idhash:
+			res = rco_reader_get_idhash(reader, attr, &(kv.type_idhash.data));
+			break;
+		default:
+			continue;
+		}
+
+		if(res < 0){
+			return -1;
+		}
+
+		*tail = arena_alloc(arena, sizeof(kv));
+		if(*tail == NULL){
+			return -1;
+		}
+
+		memcpy(*tail, &kv, sizeof(kv));
+
+		switch(kv.key_id){
+		case RCO_NAME_ID:
+			slot_type = (tag->name_id == RCO_NAME_LOCALE) ? attr_type_id : attr_type_idhash;
+			break;
+		case RCO_NAME_TYPE:
+		case RCO_NAME_COMPRESS:
+			slot_type = attr_type_string;
+			break;
+		case RCO_NAME_ORIGSIZE:
+			slot_type = attr_type_int;
+			break;
+		default:
+			slot_type = -1;
+			break;
+		}
+
+		if(kv.type == slot_type && CXML_TAG_KEY(tag, kv.key_id) == NULL){
+			CXML_TAG_KEY(tag, kv.key_id) = *tail;
+		}
+
+		tail = &((*tail)->next);
+	}
+
+	// payload_job_create names the output after these
+	if(CXML_TAG_KEY(tag, RCO_NAME_ID) == NULL){
+		return -1;
+	}
+
+	if(tag->name_id != RCO_NAME_LOCALE && CXML_TAG_KEY(tag, RCO_NAME_TYPE) == NULL){
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Writes the payload of the first element whose id (or idhash, for a query
+ * starting with 0x) is query. The tree section is scanned once as a flat
+ * array of elements, and only the element found is decoded.
+ */
+int RcoExtract_core(const char *plugin_name, const void *rco_data, int rco_size, const char *query, RcoDecompilerContext *ctx){
+
+	int res, is_hash = 0;
+	SceUInt32 hash = 0;
+	RcoReader reader;
+	int32_t element = -1;
+
+	if(rco_reader_open(&reader, rco_data, rco_size) < 0 || reader.is_rcs != 0){
+		printf("Not an RCO or a table is out of range\n");
+		return -1;
+	}
+
+	if(strncmp(query, "0x", 2) == 0 || strncmp(query, "0X", 2) == 0){
+		char *end;
+
+		hash = strtoul(&(query[2]), &end, 16);
+		if(query[2] == 0 || *end != 0){
+			printf("bad idhash \"%s\"\n", query);
+			return -1;
+		}
+
+		is_hash = 1;
+	}
+
+	// Elements are stored back to back, each followed by its attributes
+	int32_t offset = 0;
+
+	while(offset + (int)sizeof(SceRcoTreeHeader) <= reader.header->tree_size){
+
+		const SceRcoTreeHeader *element_header = rco_reader_get_element(&reader, offset);
+		if(element_header == NULL){
+			printf("element at 0x%X has a bad attribute count\n", offset);
+			return -1;
+		}
+
+		res = rco_extract_match(&reader, offset, query, is_hash, hash);
+		if(res < 0){
+			printf("element at 0x%X has an attribute out of range\n", offset);
+			return res;
+		}
+
+		if(res != 0){
+			element = offset;
+			break;
+		}
+
+		offset += sizeof(SceRcoTreeHeader) + sizeof(SceRcoAttribute) * element_header->num_attributes;
+	}
+
+	if(element < 0){
+		printf("no payload with id \"%s\"\n", query);
+		return -1;
+	}
+
+	RcoNameCache names;
+	CXmlTag *tag;
+	CXmlKeyValue *kv;
+	PayloadJob *job = NULL;
+
+	res = rco_name_cache_init(&names, ctx->arena, rco_data);
+	if(res < 0){
+		return res;
+	}
+
+	tag = arena_alloc(ctx->arena, sizeof(*tag));
+	if(tag == NULL){
+		return -1;
+	}
+
+	memset(tag, 0, sizeof(*tag));
+
+	res = rco_extract_decode(ctx->arena, &names, &reader, element, tag);
+	if(res < 0){
+		printf("element at 0x%X has an attribute out of range or of the wrong type\n", element);
+		return res;
+	}
+
+	ctx->output_path = plugin_name;
+
+	for(kv=tag->kv;kv!=NULL;kv=kv->next){
+		if(kv->type == attr_type_filename){
+			res = payload_job_create(ctx, kv, &job);
+			break;
+		}
+	}
+
+	if(res < 0){
+		return res;
+	}
+
+	if(job == NULL){
+		printf("%s \"%s\" has no payload to extract\n", tag->name, query);
+		return -1;
+	}
+
+	// A single payload, so it is written here instead of on the pool
+	res = payload_job_entry(job);
+	if(res >= 0){
+		printf("%s\n", (job->xml_name != NULL && (ctx->flags & RCO_DEC_FLAG_NO_RCS) != 0) ? job->xml_name : job->path);
+	}
+
+	return res;
+}
+
+int RcoExtract(const char *path, const char *query, const RcoDecompilerOption *opt){
+
+	int res;
+	FileMap map;
+	Arena arena;
+	RcoDecompilerContext ctx;
+	char *plugin_name;
+
+	res = file_map_open(path, &map);
+	if(res < 0){
+		return res;
+	}
+
+	plugin_name = rco_dec_make_plugin_name(path);
+	if(plugin_name == NULL){
+		file_map_close(&map);
+		return -1;
+	}
+
+	arena_init(&arena, 0);
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.arena = &arena;
+	ctx.pool  = NULL;
+	ctx.flags = opt->flags;
+
+	res = RcoExtract_core(plugin_name, map.data, map.size, query, &ctx);
+
+	arena_fini(&arena);
+
+	free(plugin_name);
+	plugin_name = NULL;
+
+	file_map_close(&map);
+
+	return res;
+}
@@ -0,0 +1,208 @@
+
+#ifndef _RCO_DECOMPILER_H_
+#define _RCO_DECOMPILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+#include "arena.h"
+#include "out_buffer.h"
+#include "hash_table.h"
+#include "thread_pool.h"
+#include "file_writer.h"
+#include "rco_stats.h"
+#include "rco_schema.h"
+#include "rco_format.h"
+#include "rco_reader.h"
+
+
+/*
+ * Names the decompiler looks for, resolved once per stringtable handle.
+ * The attribute names from RCO_NAME_FIRST_KEY on also get a slot in
+ * CXmlTag, so their value is found without walking the attribute list.
+ */
+enum {
+	RCO_NAME_OTHER = 0,
+	RCO_NAME_RESOURCE,
+	RCO_NAME_STRINGTABLE,
+	RCO_NAME_LOCALE,
+	RCO_NAME_TEXTURE,
+	RCO_NAME_FILE,
+	RCO_NAME_SOUNDDATA,
+	RCO_NAME_ID,
+	RCO_NAME_TYPE,
+	RCO_NAME_SRC,
+	RCO_NAME_COMPRESS,
+	RCO_NAME_ORIGSIZE,
+	RCO_NAME_MAX
+};
+
+#define RCO_NAME_FIRST_KEY RCO_NAME_ID
+#define RCO_KEY_SLOT_MAX   (RCO_NAME_MAX - RCO_NAME_FIRST_KEY)
+
+// handle -> RCO_NAME_*, filled in as handles are seen
+typedef struct RcoNameCache {
+	uint8_t *ids;
+	int size;
+} RcoNameCache;
+
+typedef struct CXmlTag CXmlTag;
+
+typedef struct CXmlKeyValue {
+	struct CXmlKeyValue *next;
+	CXmlTag *tag;
+	const char *key;
+	int key_id; // RCO_NAME_*
+
+	int type;
+	union {
+		struct {
+			int data;
+		} type_int;
+		struct {
+			float data;
+		} type_float;
+		struct {
+			const char *data;
+			int len;
+		} type_string;
+		struct {
+			const SceWChar16 *data;
+			int len;
+		} type_wstring;
+		struct {
+			SceUInt32 data;
+		} type_hash;
+		struct {
+			const SceInt32 *data;
+			int size;
+		} type_intarray;
+		struct {
+			const float *data;
+			int size;
+		} type_floatarray;
+		struct {
+			const char *output;
+			const void *data;
+			int size;
+		} type_filename;
+		struct {
+			const char *data;
+			int len;
+		} type_id;
+		struct {
+			int unk; // TODO
+		} type_idref;
+		struct {
+			SceUInt32 data;
+		} type_idhash;
+		struct {
+			SceUInt32 data;
+		} type_idhashref;
+	};
+} CXmlKeyValue;
+
+typedef struct CXmlTag {
+	struct CXmlTag *parent;
+	struct CXmlTag *child;
+	struct CXmlTag *next;
+	const char *name;
+	int name_id; // RCO_NAME_*
+	CXmlKeyValue *kv;
+	CXmlKeyValue *key_slot[RCO_KEY_SLOT_MAX]; // First attribute of each well-known name, or NULL
+	uint64_t hash; // Hash of the element and everything below it, only set by RcoDiff
+} CXmlTag;
+
+#define CXML_TAG_KEY(tag, name_id) ((tag)->key_slot[(name_id) - RCO_NAME_FIRST_KEY])
+
+#define RCO_DEC_FLAG_NO_RCS      (1 << 0) // Do not keep the locale .rcs files
+#define RCO_DEC_FLAG_NO_DEDUP    (1 << 1) // Write duplicate payloads as separate files
+#define RCO_DEC_FLAG_NO_PAYLOAD  (1 << 2) // Resolve the payload paths but write no payload files
+#define RCO_DEC_FLAG_SCHEMA      (1 << 3) // Write the attribute types next to the XML for the compiler
+#define RCO_DEC_FLAG_RAW_PAYLOAD (1 << 4) // Write compressed payloads as stored, without inflating them
+
+// The output format takes two bits of the flags, so the cache key covers it
+#define RCO_DEC_FORMAT_SHIFT (5)
+#define RCO_DEC_FORMAT_MASK  (3 << RCO_DEC_FORMAT_SHIFT)
+#define RCO_DEC_FORMAT_XML   (0 << RCO_DEC_FORMAT_SHIFT) // Indented XML, the only one --compile reads
+#define RCO_DEC_FORMAT_JSON  (1 << RCO_DEC_FORMAT_SHIFT) // One JSON object per element and line
+#define RCO_DEC_FORMAT_BIN   (2 << RCO_DEC_FORMAT_SHIFT) // Length-prefixed binary dump, see rco_emit.c
+
+typedef struct RcoDecompilerOption {
+	int flags;
+	const char *cache_dir; // NULL to disable the result cache
+	FILE *stats_fp;        // NULL to disable, otherwise one JSON line per input
+} RcoDecompilerOption;
+
+typedef struct PayloadJob PayloadJob;
+
+typedef struct RcoDecompilerContext {
+	Arena *arena;
+	ThreadPool *pool; // NULL to extract payloads on the calling thread
+	const char *output_path;
+	int flags;
+	HashTable *payload_index; // Extracted payloads by offset and by content
+	PayloadJob *duplicates;   // Linked to their original once those are written
+	RcoStats *stats;          // NULL when not collected
+	RcoSchema *schema;        // Attribute types are recorded here if not NULL
+	FileWriter *writer;       // Payloads written as stored are batched here if not NULL
+} RcoDecompilerContext;
+
+
+const char *rco_dec_get_string(const void *rco_data, int attr);
+const SceWChar16 *rco_dec_get_wstring(const void *rco_data, int attr);
+int sce_paf_wcslen(const SceWChar16 *wstr);
+
+int search_tag_key_by_name(CXmlTag *cxml, const char *name, CXmlKeyValue **result);
+int search_tag_child_by_name(CXmlTag *cxml, const char *name, CXmlTag **result);
+int search_tag_child_by_id(CXmlTag *cxml, int name_id, CXmlTag **result);
+
+int rco_name_cache_init(RcoNameCache *cache, Arena *arena, const void *rco_data);
+int rco_name_resolve(RcoNameCache *cache, const void *rco_data, int handle);
+
+int parse_element_tags(Arena *arena, RcoNameCache *names, const void *rco_data, const void *element, CXmlTag *tag, CXmlKeyValue **result);
+int parse_element(Arena *arena, const void *rco_data, const void *element, CXmlTag *parent, CXmlTag **result);
+
+/*
+ * Checks through rco_reader every element, attribute and link that
+ * parse_element follows, so it can be used on an untrusted file afterwards.
+ * Returns < 0 if anything is out of range or a link does not point forward.
+ */
+int rco_dec_check_tree(const RcoReader *reader);
+
+int payload_job_create(RcoDecompilerContext *ctx, CXmlKeyValue *kv, PayloadJob **ppJob);
+int payload_job_submit(RcoDecompilerContext *ctx, CXmlKeyValue *kv, const char **pPath);
+
+const char *rco_dec_format_extension(int flags);
+int print_cxml_record(RcoDecompilerContext *ctx, CXmlTag *cxml, uint64_t *attr_type);
+void print_cxml_record_fini(RcoDecompilerContext *ctx, uint64_t nElement, const uint64_t *attr_type);
+
+int print_cxml_tags(RcoDecompilerContext *ctx, OutBuffer *out, CXmlKeyValue *kv);
+int print_cxml(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml, int level);
+int print_cxml_json(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml);
+int print_cxml_bin(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml);
+int print_cxml_document(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml);
+
+int RcsDecompiler_core(const char *xml_name, const void *rcs_data, int rcs_size, RcoDecompilerContext *ctx);
+int RcsDecompiler(const char *xml_name, const char *path, RcoDecompilerContext *ctx);
+
+// The output directory, ./<name>/, of an input path: its file name without the extension (malloc'd)
+char *rco_dec_make_plugin_name(const char *path);
+
+int RcoDecompiler_core(const char *plugin_name, const void *rco_data, int rco_size, RcoDecompilerContext *ctx);
+// Writes to output_dir/ instead, with the file names still made from plugin_name
+int RcoDecompiler_core_into(const char *output_dir, const char *plugin_name, const void *rco_data, int rco_size, RcoDecompilerContext *ctx);
+int RcoDecompiler(const char *path, const RcoDecompilerOption *opt, Arena *arena, ThreadPool *pool);
+
+int RcoExtract_core(const char *plugin_name, const void *rco_data, int rco_size, const char *query, RcoDecompilerContext *ctx);
+int RcoExtract(const char *path, const char *query, const RcoDecompilerOption *opt);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_DECOMPILER_H_ */
@@ -0,0 +1,584 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "file_map.h"
+#include "hash_table.h"
+#include "utf16_xml.h"
+#include "rco_diff.h"
+
+
+typedef struct RcoDiffChild {
+	CXmlTag *tag;
+	const char *key;
+	int is_matched;
+} RcoDiffChild;
+
+typedef struct RcoDiffCounter {
+	const char *name;
+	int count;
+} RcoDiffCounter;
+
+typedef struct RcoDiffState {
+	OutBuffer *out;
+	Arena *arena;
+	RcoDiffResult result;
+	char path[0x800];
+	size_t path_len;
+} RcoDiffState;
+
+static uint64_t rco_diff_hash_kv(const CXmlKeyValue *kv, uint64_t seed){
+
+	uint64_t h = hash_table_hash_bytes(kv->key, strlen(kv->key), seed ^ kv->type);
+
+	switch(kv->type){
+	case attr_type_int:
+		return hash_table_hash_bytes(&(kv->type_int.data), sizeof(kv->type_int.data), h);
+	case attr_type_float:
+		return hash_table_hash_bytes(&(kv->type_float.data), sizeof(kv->type_float.data), h);
+	case attr_type_string:
+		return hash_table_hash_bytes(kv->type_string.data, kv->type_string.len, h);
+	case attr_type_wstring:
+		return hash_table_hash_bytes(kv->type_wstring.data, kv->type_wstring.len * sizeof(SceWChar16), h);
+	case attr_type_hash:
+		return hash_table_hash_bytes(&(kv->type_hash.data), sizeof(kv->type_hash.data), h);
+	case attr_type_intarray:
+		return hash_table_hash_bytes(kv->type_intarray.data, kv->type_intarray.size * sizeof(SceInt32), h);
+	case attr_type_floatarray:
+		return hash_table_hash_bytes(kv->type_floatarray.data, kv->type_floatarray.size * sizeof(float), h);
+	case attr_type_filename:
+		// By content, so a payload that only moved in the filetable is the same
+		return hash_table_hash_bytes(kv->type_filename.data, kv->type_filename.size, h);
+	case attr_type_id:
+		return hash_table_hash_bytes(kv->type_id.data, kv->type_id.len, h);
+	case attr_type_idhash:
+		return hash_table_hash_bytes(&(kv->type_idhash.data), sizeof(kv->type_idhash.data), h);
+	case attr_type_idhashref:
+		return hash_table_hash_bytes(&(kv->type_idhashref.data), sizeof(kv->type_idhashref.data), h);
+	default:
+		return h;
+	}
+}
+
+static uint64_t rco_diff_hash_self(const CXmlTag *tag){
+
+	uint64_t h = hash_table_hash_bytes(tag->name, strlen(tag->name), 0);
+
+	for(const CXmlKeyValue *kv=tag->kv;kv!=NULL;kv=kv->next){
+		h = rco_diff_hash_kv(kv, h);
+	}
+
+	return h;
+}
+
+// Sets tag->hash bottom up, each element once its last child is done
+static void rco_diff_hash_tree(CXmlTag *cxml){
+
+	while(cxml != NULL){
+
+		if(cxml->child != NULL){
+			cxml = cxml->child;
+			continue;
+		}
+
+		while(1){
+			uint64_t h = rco_diff_hash_self(cxml);
+
+			for(const CXmlTag *child=cxml->child;child!=NULL;child=child->next){
+				h = hash_table_hash_u64(h ^ child->hash);
+			}
+
+			cxml->hash = h;
+
+			if(cxml->next != NULL || cxml->parent == NULL){
+				break;
+			}
+
+			cxml = cxml->parent;
+		}
+
+		cxml = cxml->next;
+	}
+}
+
+static const CXmlKeyValue *rco_diff_get_id(const CXmlTag *tag){
+
+	for(const CXmlKeyValue *kv=tag->kv;kv!=NULL;kv=kv->next){
+		if(kv->type == attr_type_id || kv->type == attr_type_idhash){
+			return kv;
+		}
+	}
+
+	return NULL;
+}
+
+// name[id], name[0xHASH] or name#n for the n-th sibling of that name without an id
+static const char *rco_diff_make_key(Arena *arena, const CXmlTag *tag, int index){
+
+	char key[0x100];
+	const CXmlKeyValue *kv_id = rco_diff_get_id(tag);
+
+	if(kv_id != NULL && kv_id->type == attr_type_id){
+		snprintf(key, sizeof(key), "%s[%.*s]", tag->name, kv_id->type_id.len, kv_id->type_id.data);
+	}else if(kv_id != NULL){
+		snprintf(key, sizeof(key), "%s[0x%08X]", tag->name, kv_id->type_idhash.data);
+	}else{
+		snprintf(key, sizeof(key), "%s#%d", tag->name, index);
+	}
+
+	return arena_strndup(arena, key, strlen(key));
+}
+
+static int rco_diff_match_counter(const void *value, const void *key){
+	return strcmp(((const RcoDiffCounter *)value)->name, (const char *)key) == 0;
+}
+
+// Keys of the children of tag, in one pass so many unnamed siblings stay linear
+static int rco_diff_make_keys(Arena *arena, const CXmlTag *tag, int nChild, const char **keys){
+
+	int res = 0, i = 0;
+	HashTable counters;
+
+	if(hash_table_init(&counters, 0x10) < 0){
+		return -1;
+	}
+
+	for(const CXmlTag *child=tag->child;child!=NULL && i<nChild;child=child->next){
+		int index = 0;
+
+		if(rco_diff_get_id(child) == NULL){
+			uint64_t hash = hash_table_hash_bytes(child->name, strlen(child->name), 0);
+			RcoDiffCounter *counter = hash_table_find(&counters, hash, rco_diff_match_counter, child->name);
+
+			if(counter == NULL){
+				counter = arena_alloc(arena, sizeof(*counter));
+				if(counter == NULL || hash_table_insert(&counters, hash, counter) < 0){
+					res = -1;
+					break;
+				}
+
+				counter->name  = child->name;
+				counter->count = 0;
+			}
+
+			index = counter->count++;
+		}
+
+		keys[i] = rco_diff_make_key(arena, child, index);
+		if(keys[i] == NULL){
+			res = -1;
+			break;
+		}
+
+		i++;
+	}
+
+	hash_table_fini(&counters);
+
+	return res;
+}
+
+static int rco_diff_match_child(const void *value, const void *key){
+
+	const RcoDiffChild *child = (const RcoDiffChild *)value;
+
+	return child->is_matched == 0 && strcmp(child->key, (const char *)key) == 0;
+}
+
+static void rco_diff_push(RcoDiffState *diff, const char *key){
+
+	int n = snprintf(&(diff->path[diff->path_len]), sizeof(diff->path) - diff->path_len, "/%s", key);
+
+	diff->path_len += n;
+	if(diff->path_len >= sizeof(diff->path)){
+		diff->path_len = sizeof(diff->path) - 1;
+	}
+}
+
+static void rco_diff_print_value(OutBuffer *out, const CXmlKeyValue *kv){
+
+	switch(kv->type){
+	case attr_type_int:
+		out_buffer_print_int(out, kv->type_int.data);
+		break;
+	case attr_type_float:
+		out_buffer_print_float_exact(out, kv->type_float.data);
+		break;
+	case attr_type_string:
+		out_buffer_putc(out, '"');
+		out_buffer_write(out, kv->type_string.data, kv->type_string.len);
+		out_buffer_putc(out, '"');
+		break;
+	case attr_type_wstring:
+		out_buffer_putc(out, '"');
+		utf16_print_xml(out, kv->type_wstring.data, kv->type_wstring.len);
+		out_buffer_putc(out, '"');
+		break;
+	case attr_type_hash:
+		out_buffer_print_hex32(out, kv->type_hash.data);
+		break;
+	case attr_type_intarray:
+		for(int i=0;i<kv->type_intarray.size;i++){
+			if(i != 0){
+				out_buffer_write(out, ", ", 2);
+			}
+
+			out_buffer_print_int(out, kv->type_intarray.data[i]);
+		}
+		break;
+	case attr_type_floatarray:
+		for(int i=0;i<kv->type_floatarray.size;i++){
+			if(i != 0){
+				out_buffer_write(out, ", ", 2);
+			}
+
+			out_buffer_print_float_exact(out, kv->type_floatarray.data[i]);
+		}
+		break;
+	case attr_type_filename:
+		out_buffer_write(out, "payload of ", 11);
+		out_buffer_print_int(out, kv->type_filename.size);
+		out_buffer_write(out, " bytes", 6);
+		break;
+	case attr_type_id:
+		out_buffer_write(out, kv->type_id.data, kv->type_id.len);
+		break;
+	case attr_type_idhash:
+		out_buffer_print_hex32(out, kv->type_idhash.data);
+		break;
+	case attr_type_idhashref:
+		out_buffer_print_hex32(out, kv->type_idhashref.data);
+		break;
+	default:
+		out_buffer_puts(out, "?");
+		break;
+	}
+}
+
+static void rco_diff_print_line(RcoDiffState *diff, char op, const CXmlKeyValue *kv){
+
+	out_buffer_putc(diff->out, op);
+	out_buffer_putc(diff->out, ' ');
+	out_buffer_write(diff->out, diff->path, diff->path_len);
+
+	if(kv != NULL){
+		out_buffer_write(diff->out, " @", 2);
+		out_buffer_puts(diff->out, kv->key);
+	}
+}
+
+static int rco_diff_count_elements(const CXmlTag *cxml){
+
+	int n = 1;
+	const CXmlTag *root = cxml;
+
+	cxml = cxml->child;
+
+	while(cxml != NULL){
+		n++;
+
+		if(cxml->child != NULL){
+			cxml = cxml->child;
+			continue;
+		}
+
+		while(cxml->next == NULL && cxml->parent != root){
+			cxml = cxml->parent;
+		}
+
+		cxml = cxml->next;
+	}
+
+	return n;
+}
+
+static void rco_diff_subtree(RcoDiffState *diff, char op, const CXmlTag *tag){
+
+	int n = rco_diff_count_elements(tag);
+
+	rco_diff_print_line(diff, op, NULL);
+
+	if(n > 1){
+		out_buffer_write(diff->out, " (", 2);
+		out_buffer_print_int(diff->out, n);
+		out_buffer_write(diff->out, " elements)", 10);
+	}
+
+	out_buffer_putc(diff->out, '\n');
+
+	if(op == '+'){
+		diff->result.nAdded += n;
+	}else{
+		diff->result.nRemoved += n;
+	}
+}
+
+// Attributes are matched by name
+static void rco_diff_attributes(RcoDiffState *diff, const CXmlTag *a, const CXmlTag *b){
+
+	int is_changed = 0;
+
+	for(const CXmlKeyValue *kv_b=b->kv;kv_b!=NULL;kv_b=kv_b->next){
+		const CXmlKeyValue *kv_a = a->kv;
+
+		while(kv_a != NULL && strcmp(kv_a->key, kv_b->key) != 0){
+			kv_a = kv_a->next;
+		}
+
+		if(kv_a == NULL){
+			rco_diff_print_line(diff, '+', kv_b);
+			out_buffer_write(diff->out, " = ", 3);
+			rco_diff_print_value(diff->out, kv_b);
+			out_buffer_putc(diff->out, '\n');
+			is_changed = 1;
+		}else if(rco_diff_hash_kv(kv_a, 0) != rco_diff_hash_kv(kv_b, 0)){
+			rco_diff_print_line(diff, '~', kv_b);
+			out_buffer_write(diff->out, ": ", 2);
+			rco_diff_print_value(diff->out, kv_a);
+			out_buffer_write(diff->out, " -> ", 4);
+			rco_diff_print_value(diff->out, kv_b);
+			out_buffer_putc(diff->out, '\n');
+			is_changed = 1;
+		}
+	}
+
+	for(const CXmlKeyValue *kv_a=a->kv;kv_a!=NULL;kv_a=kv_a->next){
+		const CXmlKeyValue *kv_b = b->kv;
+
+		while(kv_b != NULL && strcmp(kv_a->key, kv_b->key) != 0){
+			kv_b = kv_b->next;
+		}
+
+		if(kv_b == NULL){
+			rco_diff_print_line(diff, '-', kv_a);
+			out_buffer_putc(diff->out, '\n');
+			is_changed = 1;
+		}
+	}
+
+	if(is_changed != 0){
+		diff->result.nChanged++;
+	}
+}
+
+/*
+ * a and b are the same element in both trees and their hashes differ. Only
+ * children whose hashes differ are looked into, so identical subtrees cost
+ * one comparison each however large they are.
+ */
+static int rco_diff_element(RcoDiffState *diff, CXmlTag *a, CXmlTag *b){
+
+	int res = 0, nChild = 0, nChild_b = 0;
+	size_t path_len = diff->path_len;
+	HashTable children;
+	RcoDiffChild *child_a;
+	const char **keys;
+
+	if(rco_diff_hash_self(a) != rco_diff_hash_self(b)){
+		rco_diff_attributes(diff, a, b);
+	}
+
+	for(CXmlTag *tag=a->child;tag!=NULL;tag=tag->next){
+		nChild++;
+	}
+
+	for(CXmlTag *tag=b->child;tag!=NULL;tag=tag->next){
+		nChild_b++;
+	}
+
+	child_a = arena_alloc(diff->arena, sizeof(*child_a) * (nChild + 1));
+	keys    = arena_alloc(diff->arena, sizeof(*keys) * (nChild + nChild_b + 1));
+	if(child_a == NULL || keys == NULL){
+		return -1;
+	}
+
+	if(rco_diff_make_keys(diff->arena, a, nChild, keys) < 0 || rco_diff_make_keys(diff->arena, b, nChild_b, &(keys[nChild])) < 0){
+		return -1;
+	}
+
+	if(hash_table_init(&children, nChild) < 0){
+		return -1;
+	}
+
+	nChild = 0;
+
+	for(CXmlTag *tag=a->child;tag!=NULL;tag=tag->next){
+		RcoDiffChild *child = &(child_a[nChild]);
+
+		child->tag        = tag;
+		child->key        = keys[nChild];
+		child->is_matched = 0;
+
+		nChild++;
+
+		if(hash_table_insert(&children, hash_table_hash_bytes(child->key, strlen(child->key), 0), child) < 0){
+			res = -1;
+			break;
+		}
+	}
+
+	int i = nChild;
+
+	for(CXmlTag *tag=b->child;tag!=NULL && res >= 0;tag=tag->next){
+		const char *key = keys[i++];
+
+		RcoDiffChild *child = hash_table_find(&children, hash_table_hash_bytes(key, strlen(key), 0), rco_diff_match_child, key);
+
+		rco_diff_push(diff, key);
+
+		if(child == NULL){
+			rco_diff_subtree(diff, '+', tag);
+		}else{
+			child->is_matched = 1;
+
+			if(child->tag->hash != tag->hash){
+				res = rco_diff_element(diff, child->tag, tag);
+			}
+		}
+
+		diff->path_len = path_len;
+		diff->path[path_len] = 0;
+	}
+
+	for(int i=0;i<nChild && res >= 0;i++){
+		if(child_a[i].is_matched != 0){
+			continue;
+		}
+
+		rco_diff_push(diff, child_a[i].key);
+		rco_diff_subtree(diff, '-', child_a[i].tag);
+
+		diff->path_len = path_len;
+		diff->path[path_len] = 0;
+	}
+
+	hash_table_fini(&children);
+
+	return res;
+}
+
+int RcoDiff_core(OutBuffer *out, Arena *arena, CXmlTag *root_a, CXmlTag *root_b, RcoDiffResult *pResult){
+
+	int res = 0;
+	RcoDiffState diff;
+
+	memset(&diff, 0, sizeof(diff));
+	diff.out   = out;
+	diff.arena = arena;
+
+	rco_diff_hash_tree(root_a);
+	rco_diff_hash_tree(root_b);
+
+	if(root_a->hash != root_b->hash){
+		rco_diff_push(&diff, root_b->name);
+
+		if(strcmp(root_a->name, root_b->name) != 0){
+			rco_diff_subtree(&diff, '-', root_a);
+			rco_diff_subtree(&diff, '+', root_b);
+		}else{
+			res = rco_diff_element(&diff, root_a, root_b);
+		}
+	}
+
+	*pResult = diff.result;
+
+	return res;
+}
+
+static int rco_diff_load(const char *path, FileMap *pMap, Arena *arena, CXmlTag **ppRoot){
+
+	int res;
+	const SceRcoHeader *pHeader;
+	RcoReader reader;
+
+	res = file_map_open(path, pMap);
+	if(res < 0){
+		printf("cannot open \"%s\"\n", path);
+		return res;
+	}
+
+	pHeader = (const SceRcoHeader *)pMap->data;
+
+	if(rco_reader_open(&reader, pMap->data, pMap->size) < 0){
+		printf("\"%s\" is not an RCO or RCS, or a table is out of range\n", path);
+		file_map_close(pMap);
+		return -1;
+	}
+
+	// parse_element trusts every offset, so the whole tree is checked first
+	if(rco_dec_check_tree(&reader) < 0){
+		printf("\"%s\" has an element or attribute out of range\n", path);
+		file_map_close(pMap);
+		return -1;
+	}
+
+	res = parse_element(arena, pMap->data, (const void *)(pMap->data + pHeader->tree_offset), NULL, ppRoot);
+	if(res >= 0 && *ppRoot == NULL){
+		res = -1;
+	}
+
+	if(res < 0){
+		printf("cannot parse \"%s\"\n", path);
+		file_map_close(pMap);
+	}
+
+	return res;
+}
+
+int RcoDiff(const char *path_a, const char *path_b){
+
+	int res;
+	FileMap map_a, map_b;
+	Arena arena;
+	OutBuffer out;
+	CXmlTag *root_a, *root_b;
+	RcoDiffResult result;
+
+	arena_init(&arena, 0);
+
+	result.nAdded = result.nRemoved = result.nChanged = 0;
+
+	res = rco_diff_load(path_a, &map_a, &arena, &root_a);
+	if(res < 0){
+		arena_fini(&arena);
+		return res;
+	}
+
+	res = rco_diff_load(path_b, &map_b, &arena, &root_b);
+	if(res < 0){
+		file_map_close(&map_a);
+		arena_fini(&arena);
+		return res;
+	}
+
+	fflush(stdout);
+
+	res = out_buffer_init(&out, stdout, 0);
+	if(res >= 0){
+		res = RcoDiff_core(&out, &arena, root_a, root_b, &result);
+
+		if(res >= 0){
+			out_buffer_print_int(&out, result.nAdded);
+			out_buffer_write(&out, " added, ", 8);
+			out_buffer_print_int(&out, result.nRemoved);
+			out_buffer_write(&out, " removed, ", 10);
+			out_buffer_print_int(&out, result.nChanged);
+			out_buffer_write(&out, " changed\n", 9);
+		}
+
+		if(out_buffer_fini(&out) < 0 && res >= 0){
+			res = -1;
+		}
+	}
+
+	int is_same = (root_a->hash == root_b->hash);
+
+	file_map_close(&map_b);
+	file_map_close(&map_a);
+	arena_fini(&arena);
+
+	if(res < 0){
+		return res;
+	}
+
+	return (is_same != 0) ? 0 : 1;
+}
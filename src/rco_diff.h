@@ -0,0 +1,34 @@
+#ifndef _RCO_DIFF_H_
+#define _RCO_DIFF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "out_buffer.h"
+#include "rco_decompiler.h"
+
+
+typedef struct RcoDiffResult {
+	int nAdded;
+	int nRemoved;
+	int nChanged;
+} RcoDiffResult;
+
+/*
+ * Compares two parsed trees and writes one line per added (+), removed (-)
+ * and changed (~) element or attribute to out. Children are matched by
+ * name and id, or by name and position among the siblings that have no id.
+ */
+int RcoDiff_core(OutBuffer *out, Arena *arena, CXmlTag *root_a, CXmlTag *root_b, RcoDiffResult *pResult);
+
+// Returns 0 if the files are the same, 1 if they differ and -1 on error
+int RcoDiff(const char *path_a, const char *path_b);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_DIFF_H_ */
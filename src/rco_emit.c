@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "utf16_xml.h"
+#include "rco_schema.h"
+#include "rco_decompiler.h"
+
+
+/*
+ * Emitters for the same decoded tree as print_cxml, both in document order
+ * with the depth of each element, so the tree is rebuilt with a stack.
+ *
+ * JSON: one object per line,
+ *   {"depth":1,"name":"texture","attributes":[{"name":"id","type":"idhash","value":"0x00000055"},...]}
+ * ints and floats are numbers (non-finite floats are null), hashes are
+ * "0x%08X" strings as in the XML, arrays are arrays and filename is the
+ * payload path (null if it is not extracted).
+ *
+ * Binary: "RCOB", u32 version, then per element
+ *   u32 depth, u32 name length, name, u32 attribute count
+ * and per attribute
+ *   u32 name length, name, u32 type (attr_type_*), u32 value length, value
+ * All integers are little endian and strings have no terminator. Values are
+ * an i32, f32 or u32 for int, float and the hashes, UTF-8 for strings, ids
+ * and the payload path, raw UTF-16LE for wstring and the raw little endian
+ * elements for the arrays, exactly as stored in the RCO.
+ */
+
+#define RCO_EMIT_BIN_VERSION (1)
+
+static void emit_json_string(OutBuffer *out, const char *str, size_t len){
+
+	static const char hex[] = "0123456789ABCDEF";
+	size_t start = 0;
+
+	out_buffer_putc(out, '"');
+
+	for(size_t i=0;i<len;i++){
+		unsigned char c = (unsigned char)str[i];
+
+		if(c >= 0x20 && c != '"' && c != '\\'){
+			continue;
+		}
+
+		out_buffer_write(out, &(str[start]), i - start);
+		start = i + 1;
+
+		if(c == '"' || c == '\\'){
+			out_buffer_putc(out, '\\');
+			out_buffer_putc(out, c);
+		}else if(c == '\n'){
+			out_buffer_write(out, "\\n", 2);
+		}else{
+			char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+			out_buffer_write(out, esc, sizeof(esc));
+		}
+	}
+
+	out_buffer_write(out, &(str[start]), len - start);
+	out_buffer_putc(out, '"');
+}
+
+static void emit_json_float(OutBuffer *out, float value){
+
+	if(isfinite(value) == 0){
+		out_buffer_write(out, "null", 4);
+		return;
+	}
+
+	out_buffer_print_float_exact(out, value);
+}
+
+static void emit_json_hash(OutBuffer *out, SceUInt32 value){
+	out_buffer_putc(out, '"');
+	out_buffer_print_hex32(out, value);
+	out_buffer_putc(out, '"');
+}
+
+static int emit_json_value(RcoDecompilerContext *ctx, OutBuffer *out, CXmlKeyValue *kv){
+
+	int res;
+
+	switch(kv->type){
+	case attr_type_int:
+		out_buffer_print_int(out, kv->type_int.data);
+		break;
+	case attr_type_float:
+		emit_json_float(out, kv->type_float.data);
+		break;
+	case attr_type_string:
+		emit_json_string(out, kv->type_string.data, kv->type_string.len);
+		break;
+	case attr_type_wstring:
+		out_buffer_putc(out, '"');
+		utf16_print_json(out, kv->type_wstring.data, kv->type_wstring.len);
+		out_buffer_putc(out, '"');
+		break;
+	case attr_type_hash:
+		emit_json_hash(out, kv->type_hash.data);
+		break;
+	case attr_type_intarray:
+		out_buffer_putc(out, '[');
+		for(int i=0;i<kv->type_intarray.size;i++){
+			if(i != 0){
+				out_buffer_putc(out, ',');
+			}
+
+			out_buffer_print_int(out, kv->type_intarray.data[i]);
+		}
+		out_buffer_putc(out, ']');
+		break;
+	case attr_type_floatarray:
+		out_buffer_putc(out, '[');
+		for(int i=0;i<kv->type_floatarray.size;i++){
+			if(i != 0){
+				out_buffer_putc(out, ',');
+			}
+
+			emit_json_float(out, kv->type_floatarray.data[i]);
+		}
+		out_buffer_putc(out, ']');
+		break;
+	case attr_type_filename:
+		{
+			const char *path;
+
+			res = payload_job_submit(ctx, kv, &path);
+			if(res < 0){
+				return res;
+			}
+
+			if(path != NULL){
+				emit_json_string(out, path, strlen(path));
+			}else{
+				out_buffer_write(out, "null", 4);
+			}
+		}
+		break;
+	case attr_type_id:
+		emit_json_string(out, kv->type_id.data, kv->type_id.len);
+		break;
+	case attr_type_idhash:
+		emit_json_hash(out, kv->type_idhash.data);
+		break;
+	case attr_type_idhashref:
+		emit_json_hash(out, kv->type_idhashref.data);
+		break;
+	default:
+		out_buffer_write(out, "null", 4);
+		break;
+	}
+
+	return 0;
+}
+
+int print_cxml_json(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml){
+
+	int res, level = 0;
+	uint64_t nElement = 0, attr_type[RCO_STATS_ATTR_TYPE_MAX];
+
+	memset(attr_type, 0, sizeof(attr_type));
+
+	while(cxml != NULL){
+
+		nElement++;
+
+		res = print_cxml_record(ctx, cxml, attr_type);
+		if(res < 0){
+			return res;
+		}
+
+		out_buffer_write(out, "{\"depth\":", 9);
+		out_buffer_print_int(out, level);
+		out_buffer_write(out, ",\"name\":", 8);
+		emit_json_string(out, cxml->name, strlen(cxml->name));
+		out_buffer_write(out, ",\"attributes\":[", 15);
+
+		for(CXmlKeyValue *kv=cxml->kv;kv!=NULL;kv=kv->next){
+			if(kv != cxml->kv){
+				out_buffer_putc(out, ',');
+			}
+
+			out_buffer_write(out, "{\"name\":", 8);
+			emit_json_string(out, kv->key, strlen(kv->key));
+			out_buffer_write(out, ",\"type\":\"", 9);
+			out_buffer_puts(out, rco_schema_get_type_name(kv->type));
+			out_buffer_write(out, "\",\"value\":", 10);
+
+			res = emit_json_value(ctx, out, kv);
+			if(res < 0){
+				return res;
+			}
+
+			out_buffer_putc(out, '}');
+		}
+
+		out_buffer_write(out, "]}\n", 3);
+
+		if(cxml->child != NULL){
+			cxml = cxml->child;
+			level++;
+			continue;
+		}
+
+		while(cxml->next == NULL && level > 0){
+			cxml = cxml->parent;
+			level--;
+		}
+
+		cxml = cxml->next;
+	}
+
+	print_cxml_record_fini(ctx, nElement, attr_type);
+
+	return 0;
+}
+
+static void emit_bin_u32(OutBuffer *out, uint32_t value){
+
+	uint8_t le[4] = {value, value >> 8, value >> 16, value >> 24};
+
+	out_buffer_write(out, le, sizeof(le));
+}
+
+static void emit_bin_bytes(OutBuffer *out, const void *data, size_t size){
+	emit_bin_u32(out, size);
+	out_buffer_write(out, data, size);
+}
+
+static int emit_bin_value(RcoDecompilerContext *ctx, OutBuffer *out, CXmlKeyValue *kv){
+
+	int res;
+	uint32_t value;
+
+	emit_bin_u32(out, kv->type);
+
+	switch(kv->type){
+	case attr_type_int:
+		emit_bin_u32(out, 4);
+		emit_bin_u32(out, kv->type_int.data);
+		break;
+	case attr_type_float:
+		memcpy(&value, &(kv->type_float.data), sizeof(value));
+		emit_bin_u32(out, 4);
+		emit_bin_u32(out, value);
+		break;
+	case attr_type_string:
+		emit_bin_bytes(out, kv->type_string.data, kv->type_string.len);
+		break;
+	case attr_type_wstring:
+		// Pointers into the RCO, which is little endian already
+		emit_bin_bytes(out, kv->type_wstring.data, kv->type_wstring.len * sizeof(SceWChar16));
+		break;
+	case attr_type_hash:
+		emit_bin_u32(out, 4);
+		emit_bin_u32(out, kv->type_hash.data);
+		break;
+	case attr_type_intarray:
+		emit_bin_bytes(out, kv->type_intarray.data, kv->type_intarray.size * sizeof(SceInt32));
+		break;
+	case attr_type_floatarray:
+		emit_bin_bytes(out, kv->type_floatarray.data, kv->type_floatarray.size * sizeof(float));
+		break;
+	case attr_type_filename:
+		{
+			const char *path;
+
+			res = payload_job_submit(ctx, kv, &path);
+			if(res < 0){
+				return res;
+			}
+
+			if(path == NULL){
+				path = "";
+			}
+
+			emit_bin_bytes(out, path, strlen(path));
+		}
+		break;
+	case attr_type_id:
+		emit_bin_bytes(out, kv->type_id.data, kv->type_id.len);
+		break;
+	case attr_type_idhash:
+		emit_bin_u32(out, 4);
+		emit_bin_u32(out, kv->type_idhash.data);
+		break;
+	case attr_type_idhashref:
+		emit_bin_u32(out, 4);
+		emit_bin_u32(out, kv->type_idhashref.data);
+		break;
+	default:
+		emit_bin_u32(out, 0);
+		break;
+	}
+
+	return 0;
+}
+
+int print_cxml_bin(RcoDecompilerContext *ctx, OutBuffer *out, CXmlTag *cxml){
+
+	int res, level = 0;
+	uint64_t nElement = 0, attr_type[RCO_STATS_ATTR_TYPE_MAX];
+
+	memset(attr_type, 0, sizeof(attr_type));
+
+	out_buffer_write(out, "RCOB", 4);
+	emit_bin_u32(out, RCO_EMIT_BIN_VERSION);
+
+	while(cxml != NULL){
+
+		int nAttribute = 0;
+
+		nElement++;
+
+		res = print_cxml_record(ctx, cxml, attr_type);
+		if(res < 0){
+			return res;
+		}
+
+		for(CXmlKeyValue *kv=cxml->kv;kv!=NULL;kv=kv->next){
+			nAttribute++;
+		}
+
+		emit_bin_u32(out, level);
+		emit_bin_bytes(out, cxml->name, strlen(cxml->name));
+		emit_bin_u32(out, nAttribute);
+
+		for(CXmlKeyValue *kv=cxml->kv;kv!=NULL;kv=kv->next){
+			emit_bin_bytes(out, kv->key, strlen(kv->key));
+
+			res = emit_bin_value(ctx, out, kv);
+			if(res < 0){
+				return res;
+			}
+		}
+
+		if(cxml->child != NULL){
+			cxml = cxml->child;
+			level++;
+			continue;
+		}
+
+		while(cxml->next == NULL && level > 0){
+			cxml = cxml->parent;
+			level--;
+		}
+
+		cxml = cxml->next;
+	}
+
+	print_cxml_record_fini(ctx, nElement, attr_type);
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef _RCO_FORMAT_H_
+#define _RCO_FORMAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+
+
+typedef int32_t SceInt32;
+typedef uint32_t SceUInt32;
+typedef unsigned short SceWChar16;
+
+
+typedef struct SceRcoHeader { // size is 0x50-bytes
+	char magic[4]; // CXML
+	SceInt32 version;  // 0x110
+	SceInt32 tree_offset;
+	SceInt32 tree_size;
+
+	SceInt32 idtable_offset;
+	SceInt32 idtable_size;
+	SceInt32 idhashtable_offset;
+	SceInt32 idhashtable_size;
+
+	// 0x20
+	SceInt32 stringtable_offset;
+	SceInt32 stringtable_size;
+	SceInt32 wstringtable_offset;
+	SceInt32 wstringtable_size;
+
+	SceInt32 hashtable_offset;
+	SceInt32 hashtable_size;
+	SceInt32 intarraytable_offset;
+	SceInt32 intarraytable_size;
+	SceInt32 floatarraytable_offset;
+	SceInt32 floatarraytable_size;
+	SceInt32 filetable_offset;
+	SceInt32 filetable_size;
+} SceRcoHeader;
+
+typedef struct SceRcoTreeHeader { // size is 0x1C-bytes
+	SceInt32 name_handle;
+	SceInt32 num_attributes;
+	SceInt32 parent_elm_offset;
+	SceInt32 prev_elm_offset;
+	SceInt32 next_elm_offset;
+	SceInt32 first_child_elm_offset;
+	SceInt32 last_child_elm_offset;
+} SceRcoTreeHeader;
+
+typedef struct SceRcoAttribute { // size is 0x10-bytes, follows the tree header
+	SceInt32 name_handle;
+	SceInt32 type; // attr_type_*
+	SceInt32 v1;
+	SceInt32 v2;
+} SceRcoAttribute;
+
+#define attr_type_int        1
+#define attr_type_float      2
+#define attr_type_string     3
+#define attr_type_wstring    4
+#define attr_type_hash       5
+#define attr_type_intarray   6
+#define attr_type_floatarray 7
+#define attr_type_filename   8
+#define attr_type_id         9
+#define attr_type_idref      10
+#define attr_type_idhash     11
+#define attr_type_idhashref  12
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_FORMAT_H_ */
@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+#include "rco_decompiler.h"
+#include "rco_writer.h"
+#include "rco_gen.h"
+
+
+typedef struct RcoGenState {
+	const RcoGenParam *param;
+	RcoWriter *writer;
+	uint32_t random;
+	uint32_t next_idhash;
+	int nElement;
+	SceWChar16 *wstr;
+} RcoGenState;
+
+void rco_gen_default_param(RcoGenParam *param){
+
+	memset(param, 0, sizeof(*param));
+
+	param->is_rcs         = 0;
+	param->nPage          = 32;
+	param->depth          = 3;
+	param->nSibling       = 4;
+	param->nAttribute     = 8;
+	param->attr_mask      = RCO_GEN_ATTR_MASK_ALL;
+	param->wstring_length = 32;
+	param->nLocale        = 4;
+	param->nLocaleString  = 256;
+	param->nPayload       = 16;
+	param->payload_size   = 0x10000;
+	param->compress       = 1;
+	param->seed           = 1;
+}
+
+uint32_t rco_gen_random(RcoGenState *state){
+
+	uint32_t x = state->random;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	state->random = x;
+
+	return x;
+}
+
+// Mostly ASCII text with XML specials, line breaks, CJK and surrogate pairs mixed in
+void rco_gen_fill_wstring(RcoGenState *state, SceWChar16 *wstr, int len){
+
+	static const SceWChar16 specials[] = {'&', '<', '>', '"', '\n', 0xE9, 0x65E5, 0x672C};
+
+	for(int i=0;i<len;i++){
+		uint32_t r = rco_gen_random(state);
+
+		if((r & 0xF) != 0){
+			wstr[i] = 'a' + ((r >> 8) % 26);
+		}else if(((r >> 4) & 3) == 0 && (i + 1) < len){
+			wstr[i++] = 0xD83D;
+			wstr[i]   = 0xDE00;
+		}else{
+			wstr[i] = specials[(r >> 8) % (sizeof(specials) / sizeof(specials[0]))];
+		}
+	}
+}
+
+// Runs of a few symbols, so it compresses roughly like image data does
+void rco_gen_fill_payload(RcoGenState *state, uint8_t *data, int size){
+
+	int i = 0;
+
+	while(i < size){
+		uint32_t r = rco_gen_random(state);
+		int run = 1 + (r & 0x1F);
+		uint8_t value = (uint8_t)(r >> 8);
+
+		if((r & 0x300) == 0){
+			run = 1;
+			value = (uint8_t)(r >> 16);
+		}
+
+		while(run-- > 0 && i < size){
+			data[i++] = value;
+		}
+	}
+}
+
+int rco_gen_add_payload(RcoGenState *state, RcoWriterElement *elm, const void *data, int size){
+
+	int res;
+
+	if(state->param->compress == 0){
+		return rco_writer_add_file(state->writer, elm, "src", data, size);
+	}
+
+	uLongf dst_size = compressBound(size);
+	void *dst = malloc(dst_size);
+	if(dst == NULL){
+		return -1;
+	}
+
+	if(compress2(dst, &dst_size, data, size, Z_DEFAULT_COMPRESSION) != Z_OK){
+		printf("%s: compress2 failed\n", __FUNCTION__);
+		free(dst);
+		return -1;
+	}
+
+	res = rco_writer_add_file(state->writer, elm, "src", dst, dst_size);
+	if(res >= 0){
+		res = rco_writer_add_string(state->writer, elm, "compress", "on");
+	}
+
+	if(res >= 0){
+		res = rco_writer_add_int(state->writer, elm, "origsize", size);
+	}
+
+	free(dst);
+
+	return res;
+}
+
+int rco_gen_add_attributes(RcoGenState *state, RcoWriterElement *elm){
+
+	const RcoGenParam *param = state->param;
+	RcoWriter *writer = state->writer;
+	int res = 0, type = 0;
+	char key[0x10], str[0x20];
+
+	for(int i=0;i<param->nAttribute && res >= 0;i++){
+
+		// Next type enabled in attr_mask, skipping the ones a plane cannot use freely
+		for(int n=0;n<16;n++){
+			type = (type % attr_type_idhashref) + 1;
+			if(type == attr_type_filename || type == attr_type_idref){
+				continue;
+			}
+
+			if((param->attr_mask & (1 << type)) != 0){
+				break;
+			}
+		}
+
+		if((param->attr_mask & (1 << type)) == 0){
+			return 0;
+		}
+
+		uint32_t r = rco_gen_random(state);
+
+		snprintf(key, sizeof(key), "attr%d", i);
+
+		switch(type){
+		case attr_type_int:
+			res = rco_writer_add_int(writer, elm, key, (int32_t)r);
+			break;
+		case attr_type_float:
+			res = rco_writer_add_float(writer, elm, key, (float)(r & 0xFFFF) / 64.0f);
+			break;
+		case attr_type_string:
+			// A small set, so the stringtable sees repeats
+			snprintf(str, sizeof(str), "style_%u", r & 0x3F);
+			res = rco_writer_add_string(writer, elm, key, str);
+			break;
+		case attr_type_wstring:
+			rco_gen_fill_wstring(state, state->wstr, param->wstring_length);
+			res = rco_writer_add_wstring(writer, elm, key, state->wstr, param->wstring_length);
+			break;
+		case attr_type_hash:
+			res = rco_writer_add_hash(writer, elm, key, r);
+			break;
+		case attr_type_intarray:
+			{
+				int32_t values[4] = {(int32_t)(r & 0xFF), (int32_t)((r >> 8) & 0xFF), -(int32_t)((r >> 16) & 0xFF), 1};
+				res = rco_writer_add_intarray(writer, elm, key, values, 1 + (r >> 30));
+			}
+			break;
+		case attr_type_floatarray:
+			{
+				float values[4] = {(float)(r & 0xFF), 0.5f, -(float)((r >> 8) & 0xFF) / 4.0f, 1.0f};
+				res = rco_writer_add_floatarray(writer, elm, key, values, 1 + (r >> 30));
+			}
+			break;
+		case attr_type_id:
+			snprintf(str, sizeof(str), "plane_%d", state->nElement);
+			res = rco_writer_add_id(writer, elm, key, str);
+			break;
+		case attr_type_idhash:
+			res = rco_writer_add_idhash(writer, elm, key, state->next_idhash++);
+			break;
+		case attr_type_idhashref:
+			res = rco_writer_add_idhashref(writer, elm, key, 0x10000000 | (r & 0xFFF));
+			break;
+		}
+	}
+
+	return res;
+}
+
+int rco_gen_add_planes(RcoGenState *state, RcoWriterElement *parent, int depth){
+
+	int res;
+
+	if(depth <= 0){
+		return 0;
+	}
+
+	for(int i=0;i<state->param->nSibling;i++){
+		RcoWriterElement *elm = rco_writer_add_element(state->writer, parent, "plane");
+		if(elm == NULL){
+			return -1;
+		}
+
+		state->nElement++;
+
+		res = rco_gen_add_attributes(state, elm);
+		if(res < 0){
+			return res;
+		}
+
+		res = rco_gen_add_planes(state, elm, depth - 1);
+		if(res < 0){
+			return res;
+		}
+	}
+
+	return 0;
+}
+
+int rco_gen_build_locale(RcoGenState *state, int locale_index, void **ppData, size_t *pSize){
+
+	const RcoGenParam *param = state->param;
+	RcoWriter *writer = NULL;
+	RcoWriterElement *root, *stringtable, *text;
+	char id[0x20];
+	int res;
+
+	res = rco_writer_create(&writer);
+	if(res < 0){
+		return res;
+	}
+
+	root        = rco_writer_add_element(writer, NULL, "resource");
+	stringtable = rco_writer_add_element(writer, root, "stringtable");
+	if(stringtable == NULL){
+		rco_writer_destroy(writer);
+		return -1;
+	}
+
+	for(int i=0;i<param->nLocaleString && res >= 0;i++){
+		text = rco_writer_add_element(writer, stringtable, "text");
+		if(text == NULL){
+			res = -1;
+			break;
+		}
+
+		snprintf(id, sizeof(id), "msg_%d_%d", locale_index, i);
+		rco_gen_fill_wstring(state, state->wstr, param->wstring_length);
+
+		res = rco_writer_add_id(writer, text, "id", id);
+		if(res >= 0){
+			res = rco_writer_add_wstring(writer, text, "src", state->wstr, param->wstring_length);
+		}
+	}
+
+	if(res >= 0){
+		res = rco_writer_finish(writer, "RCSF", ppData, pSize);
+	}
+
+	rco_writer_destroy(writer);
+
+	return res;
+}
+
+int rco_gen_build_plugin(RcoGenState *state){
+
+	const RcoGenParam *param = state->param;
+	RcoWriter *writer = state->writer;
+	RcoWriterElement *root, *table, *elm;
+	char id[0x20];
+	int res;
+
+	root = rco_writer_add_element(writer, NULL, "resource");
+	if(root == NULL || rco_writer_add_float(writer, root, "version", 1.0f) < 0){
+		return -1;
+	}
+
+	table = rco_writer_add_element(writer, root, "stringtable");
+	if(table == NULL){
+		return -1;
+	}
+
+	for(int i=0;i<param->nLocale;i++){
+		void *locale_data;
+		size_t locale_size;
+
+		res = rco_gen_build_locale(state, i, &locale_data, &locale_size);
+		if(res < 0){
+			return res;
+		}
+
+		elm = rco_writer_add_element(writer, table, "locale");
+		snprintf(id, sizeof(id), "lang%02d", i);
+
+		res = (elm != NULL) ? rco_writer_add_id(writer, elm, "id", id) : -1;
+		if(res >= 0){
+			res = rco_gen_add_payload(state, elm, locale_data, locale_size);
+		}
+
+		free(locale_data);
+
+		if(res < 0){
+			return res;
+		}
+	}
+
+	table = rco_writer_add_element(writer, root, "texturetable");
+	if(table == NULL){
+		return -1;
+	}
+
+	if(param->nPayload != 0){
+		uint8_t *payload = malloc(param->payload_size);
+		if(payload == NULL){
+			return -1;
+		}
+
+		res = 0;
+
+		for(int i=0;i<param->nPayload && res >= 0;i++){
+			elm = rco_writer_add_element(writer, table, "texture");
+			if(elm == NULL){
+				res = -1;
+				break;
+			}
+
+			rco_gen_fill_payload(state, payload, param->payload_size);
+
+			res = rco_writer_add_idhash(writer, elm, "id", state->next_idhash++);
+			if(res >= 0){
+				res = rco_writer_add_string(writer, elm, "type", "texture/gim");
+			}
+
+			if(res >= 0){
+				res = rco_gen_add_payload(state, elm, payload, param->payload_size);
+			}
+		}
+
+		free(payload);
+
+		if(res < 0){
+			return res;
+		}
+	}
+
+	table = rco_writer_add_element(writer, root, "pagetable");
+	if(table == NULL){
+		return -1;
+	}
+
+	for(int i=0;i<param->nPage;i++){
+		elm = rco_writer_add_element(writer, table, "page");
+		snprintf(id, sizeof(id), "page_%d", i);
+
+		if(elm == NULL || rco_writer_add_id(writer, elm, "id", id) < 0){
+			return -1;
+		}
+
+		res = rco_gen_add_planes(state, elm, param->depth);
+		if(res < 0){
+			return res;
+		}
+	}
+
+	return 0;
+}
+
+int rco_gen_build(const RcoGenParam *param, void **ppData, size_t *pSize){
+
+	int res;
+	RcoGenState state;
+
+	memset(&state, 0, sizeof(state));
+
+	state.param       = param;
+	state.random      = (param->seed != 0) ? param->seed : 1;
+	state.next_idhash = 0x10000000;
+
+	state.wstr = malloc((param->wstring_length + 1) * sizeof(SceWChar16));
+	if(state.wstr == NULL){
+		return -1;
+	}
+
+	if(param->is_rcs != 0){
+		res = rco_gen_build_locale(&state, 0, ppData, pSize);
+		free(state.wstr);
+		return res;
+	}
+
+	res = rco_writer_create(&(state.writer));
+	if(res >= 0){
+		res = rco_gen_build_plugin(&state);
+		if(res >= 0){
+			res = rco_writer_finish(state.writer, "RCOF", ppData, pSize);
+		}
+
+		rco_writer_destroy(state.writer);
+	}
+
+	free(state.wstr);
+
+	return res;
+}
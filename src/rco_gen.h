@@ -0,0 +1,45 @@
+
+#ifndef _RCO_GEN_H_
+#define _RCO_GEN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define RCO_GEN_ATTR_MASK_ALL (0x1FFE)
+
+typedef struct RcoGenParam {
+	int is_rcs;         // write a locale RCSF instead of a plugin RCOF
+	int nPage;          // pages under pagetable
+	int depth;          // levels of planes below each page
+	int nSibling;       // planes per level
+	int nAttribute;     // attributes per plane
+	int attr_mask;      // (1 << attr_type_x) of the types to rotate through
+	int wstring_length; // UTF-16 units per wstring
+	int nLocale;        // embedded locale RCS
+	int nLocaleString;  // strings per locale
+	int nPayload;       // textures
+	int payload_size;   // bytes per texture before compression
+	int compress;       // store the payloads and locales with zlib
+	uint32_t seed;
+} RcoGenParam;
+
+void rco_gen_default_param(RcoGenParam *param);
+
+/*
+ * Builds a synthetic but structurally valid RCO/RCS image. *ppData is
+ * allocated with malloc and owned by the caller.
+ */
+int rco_gen_build(const RcoGenParam *param, void **ppData, size_t *pSize);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_GEN_H_ */
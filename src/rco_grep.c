@@ -0,0 +1,379 @@
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "file_map.h"
+#include "thread_pool.h"
+#include "utf16_xml.h"
+#include "rco_reader.h"
+#include "rco_grep.h"
+
+
+#define RCO_GREP_DEPTH_MAX (0x40)
+
+typedef struct RcoGrepJob {
+	const char *path;
+	const RcoGrepQuery *query;
+	FILE *output; // tmpfile, copied to stdout once all jobs are done
+	int res;
+} RcoGrepJob;
+
+int rco_grep_query_init(RcoGrepQuery *pQuery, const char *pattern){
+
+	memset(pQuery, 0, sizeof(*pQuery));
+
+	pQuery->text     = pattern;
+	pQuery->text_len = strlen(pattern);
+
+	if(pQuery->text_len == 0){
+		return -1;
+	}
+
+	if(strncmp(pattern, "0x", 2) == 0 || strncmp(pattern, "0X", 2) == 0){
+		char *end;
+
+		pQuery->hash = strtoul(&(pattern[2]), &end, 16);
+		if(pattern[2] != 0 && *end == 0){
+			pQuery->is_hash = 1;
+			return 0;
+		}
+	}
+
+	pQuery->wtext = malloc(sizeof(*pQuery->wtext) * pQuery->text_len);
+	if(pQuery->wtext == NULL){
+		return -1;
+	}
+
+	pQuery->wtext_len = utf8_to_utf16(pQuery->wtext, pattern, pQuery->text_len);
+
+	return 0;
+}
+
+int rco_grep_query_fini(RcoGrepQuery *pQuery){
+
+	free(pQuery->wtext);
+	pQuery->wtext = NULL;
+
+	return 0;
+}
+
+// memmem that only accepts hits at a multiple of align from data
+static int rco_grep_find(const void *data, size_t size, const void *needle, size_t needle_size, size_t align){
+
+	const char *p = (const char *)data;
+	const char *end = p + size;
+
+	while(p < end){
+		const char *hit = memmem(p, end - p, needle, needle_size);
+		if(hit == NULL){
+			return 0;
+		}
+
+		if((hit - (const char *)data) % align == 0){
+			return 1;
+		}
+
+		p = hit + 1;
+	}
+
+	return 0;
+}
+
+static int rco_grep_scan_table(const RcoReader *reader, SceInt32 offset, SceInt32 size, const void *needle, size_t needle_size, size_t align){
+
+	if(size <= 0){
+		return 0;
+	}
+
+	return rco_grep_find(reader->data + offset, size, needle, needle_size, align);
+}
+
+// Most files have no hit in any table and are done here
+static int rco_grep_scan_tables(const RcoReader *reader, const RcoGrepQuery *pQuery){
+
+	const SceRcoHeader *pHeader = reader->header;
+
+	if(pQuery->is_hash != 0){
+		// Stored little endian, like the rest of the file
+		uint8_t le[4] = {pQuery->hash, pQuery->hash >> 8, pQuery->hash >> 16, pQuery->hash >> 24};
+
+		return rco_grep_scan_table(reader, pHeader->hashtable_offset, pHeader->hashtable_size, le, sizeof(le), 4)
+			|| rco_grep_scan_table(reader, pHeader->idhashtable_offset, pHeader->idhashtable_size, le, sizeof(le), 4);
+	}
+
+	return rco_grep_scan_table(reader, pHeader->stringtable_offset, pHeader->stringtable_size, pQuery->text, pQuery->text_len, 1)
+		|| rco_grep_scan_table(reader, pHeader->idtable_offset, pHeader->idtable_size, pQuery->text, pQuery->text_len, 1)
+		|| rco_grep_scan_table(reader, pHeader->wstringtable_offset, pHeader->wstringtable_size, pQuery->wtext, pQuery->wtext_len * sizeof(uint16_t), sizeof(uint16_t));
+}
+
+// Returns 1 if the value of attr matches, 0 if not and -1 if it is out of range
+static int rco_grep_match(const RcoReader *reader, const SceRcoAttribute *attr, const RcoGrepQuery *pQuery){
+
+	const char *str;
+	const SceWChar16 *wstr;
+	size_t len;
+	SceUInt32 hash;
+
+	if(pQuery->is_hash != 0){
+		switch(attr->type){
+		case attr_type_hash:
+			if(rco_reader_get_hash(reader, attr, &hash) < 0){
+				return -1;
+			}
+
+			return hash == pQuery->hash;
+		case attr_type_idhash:
+		case attr_type_idhashref:
+			if(rco_reader_get_idhash(reader, attr, &hash) < 0){
+				return -1;
+			}
+
+			return hash == pQuery->hash;
+		default:
+			return 0;
+		}
+	}
+
+	switch(attr->type){
+	case attr_type_string:
+		if(rco_reader_get_string(reader, attr->v1, &str, &len) < 0){
+			return -1;
+		}
+
+		return memmem(str, len, pQuery->text, pQuery->text_len) != NULL;
+	case attr_type_id:
+		if(rco_reader_get_id(reader, attr, &str, &len) < 0){
+			return -1;
+		}
+
+		return memmem(str, len, pQuery->text, pQuery->text_len) != NULL;
+	case attr_type_wstring:
+		if(rco_reader_get_wstring(reader, attr, &wstr, &len) < 0){
+			return -1;
+		}
+
+		return rco_grep_find(wstr, len * sizeof(SceWChar16), pQuery->wtext, pQuery->wtext_len * sizeof(uint16_t), sizeof(uint16_t));
+	default:
+		return 0;
+	}
+}
+
+static void rco_grep_print_value(OutBuffer *out, const RcoReader *reader, const SceRcoAttribute *attr){
+
+	const char *str;
+	const SceWChar16 *wstr;
+	size_t len;
+	SceUInt32 hash;
+
+	if(rco_reader_get_string(reader, attr->v1, &str, &len) >= 0 && attr->type == attr_type_string){
+		out_buffer_write(out, str, len);
+	}else if(rco_reader_get_id(reader, attr, &str, &len) >= 0){
+		out_buffer_write(out, str, len);
+	}else if(rco_reader_get_wstring(reader, attr, &wstr, &len) >= 0){
+		utf16_print_xml(out, wstr, len);
+	}else if(rco_reader_get_hash(reader, attr, &hash) >= 0 || rco_reader_get_idhash(reader, attr, &hash) >= 0){
+		out_buffer_print_hex32(out, hash);
+	}
+}
+
+// /name/name[id]/..., with the id or idhash of the elements that have one
+static void rco_grep_print_path(OutBuffer *out, const RcoReader *reader, int32_t offset){
+
+	int32_t chain[RCO_GREP_DEPTH_MAX];
+	int nChain = 0;
+
+	while(offset >= 0 && nChain < RCO_GREP_DEPTH_MAX){
+		chain[nChain++] = offset;
+		offset = rco_reader_get_parent(reader, offset);
+	}
+
+	if(offset >= 0){
+		out_buffer_write(out, "/...", 4);
+	}
+
+	while(nChain != 0){
+		const SceRcoTreeHeader *element = rco_reader_get_element(reader, chain[--nChain]);
+		const char *name;
+		size_t len;
+
+		out_buffer_putc(out, '/');
+
+		if(rco_reader_get_string(reader, element->name_handle, &name, &len) >= 0){
+			out_buffer_write(out, name, len);
+		}
+
+		for(int i=0;i<element->num_attributes;i++){
+			const SceRcoAttribute *attr = rco_reader_get_attribute(reader, chain[nChain], i);
+
+			if(attr->type == attr_type_id || attr->type == attr_type_idhash){
+				out_buffer_putc(out, '[');
+				rco_grep_print_value(out, reader, attr);
+				out_buffer_putc(out, ']');
+				break;
+			}
+		}
+	}
+}
+
+int RcoGrep_core(OutBuffer *out, const char *path, const void *data, size_t size, const RcoGrepQuery *pQuery){
+
+	int res, nMatch = 0;
+	RcoReader reader;
+
+	if(rco_reader_open(&reader, data, size) < 0){
+		out_buffer_puts(out, path);
+		out_buffer_puts(out, ": not an RCO or a table is out of range\n");
+		return -1;
+	}
+
+	if(rco_grep_scan_tables(&reader, pQuery) == 0){
+		return 0;
+	}
+
+	// Elements are stored back to back, each followed by its attributes
+	int32_t offset = 0;
+
+	while(offset + (int)sizeof(SceRcoTreeHeader) <= reader.header->tree_size){
+
+		const SceRcoTreeHeader *element = rco_reader_get_element(&reader, offset);
+		if(element == NULL){
+			out_buffer_puts(out, path);
+			out_buffer_puts(out, ": broken element in the tree\n");
+			return -1;
+		}
+
+		for(int i=0;i<element->num_attributes;i++){
+			const SceRcoAttribute *attr = rco_reader_get_attribute(&reader, offset, i);
+			const char *name;
+			size_t len;
+
+			res = rco_grep_match(&reader, attr, pQuery);
+			if(res < 0){
+				out_buffer_puts(out, path);
+				out_buffer_puts(out, ": attribute out of range\n");
+				return res;
+			}
+
+			if(res == 0){
+				continue;
+			}
+
+			nMatch++;
+
+			out_buffer_puts(out, path);
+			out_buffer_write(out, ": ", 2);
+			rco_grep_print_path(out, &reader, offset);
+			out_buffer_write(out, " @", 2);
+
+			if(rco_reader_get_string(&reader, attr->name_handle, &name, &len) >= 0){
+				out_buffer_write(out, name, len);
+			}
+
+			out_buffer_write(out, " = ", 3);
+			rco_grep_print_value(out, &reader, attr);
+			out_buffer_putc(out, '\n');
+		}
+
+		offset += sizeof(SceRcoTreeHeader) + sizeof(SceRcoAttribute) * element->num_attributes;
+	}
+
+	return nMatch;
+}
+
+static int rco_grep_job_entry(void *argp){
+
+	RcoGrepJob *job = (RcoGrepJob *)argp;
+	FileMap map;
+	OutBuffer out;
+
+	// Not open_memstream: OutBuffer makes its stream unbuffered, which glibc
+	// memory streams do not support
+	job->output = tmpfile();
+	if(job->output == NULL){
+		printf("%s: cannot create a temporary file\n", job->path);
+		job->res = -1;
+		return -1;
+	}
+
+	if(out_buffer_init(&out, job->output, 0x1000) < 0){
+		job->res = -1;
+		return -1;
+	}
+
+	if(file_map_open(job->path, &map) < 0){
+		out_buffer_puts(&out, job->path);
+		out_buffer_puts(&out, ": cannot open\n");
+		job->res = -1;
+	}else{
+		job->res = RcoGrep_core(&out, job->path, map.data, map.size, job->query);
+		file_map_close(&map);
+	}
+
+	if(out_buffer_fini(&out) < 0){
+		job->res = -1;
+	}
+
+	// Failures are reported with the output, the pool has nothing to add
+	return 0;
+}
+
+int RcoGrep(const char * const *paths, int nPath, const char *pattern, int nThread){
+
+	int res = 0, nMatch = 0;
+	RcoGrepQuery query;
+	RcoGrepJob *jobs;
+	ThreadPool *pPool = NULL;
+
+	if(rco_grep_query_init(&query, pattern) < 0){
+		printf("bad pattern \"%s\"\n", pattern);
+		return -1;
+	}
+
+	jobs = calloc(nPath, sizeof(*jobs));
+	if(jobs == NULL){
+		rco_grep_query_fini(&query);
+		return -1;
+	}
+
+	if(nThread != 1 && nPath > 1 && thread_pool_create(&pPool, nThread) < 0){
+		pPool = NULL;
+	}
+
+	for(int i=0;i<nPath;i++){
+		jobs[i].path  = paths[i];
+		jobs[i].query = &query;
+		thread_pool_submit(pPool, rco_grep_job_entry, &(jobs[i]));
+	}
+
+	thread_pool_wait(pPool);
+	thread_pool_destroy(pPool);
+	pPool = NULL;
+
+	fflush(stdout);
+
+	for(int i=0;i<nPath;i++){
+		if(jobs[i].output != NULL){
+			char buf[0x1000];
+			size_t size;
+
+			rewind(jobs[i].output);
+
+			while((size = fread(buf, 1, sizeof(buf), jobs[i].output)) != 0){
+				fwrite(buf, 1, size, stdout);
+			}
+
+			fclose(jobs[i].output);
+		}
+
+		if(jobs[i].res < 0){
+			res = -1;
+		}else{
+			nMatch += jobs[i].res;
+		}
+	}
+
+	free(jobs);
+	rco_grep_query_fini(&query);
+
+	return (res < 0) ? res : nMatch;
+}
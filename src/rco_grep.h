@@ -0,0 +1,50 @@
+#ifndef _RCO_GREP_H_
+#define _RCO_GREP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "out_buffer.h"
+#include "rco_format.h"
+
+
+/*
+ * A pattern of the form 0x%X is a hash, matched against hash, idhash and
+ * idhashref values. Anything else is text, found inside string and id
+ * values and, as UTF-16, inside wstring values.
+ */
+typedef struct RcoGrepQuery {
+	const char *text;
+	size_t text_len;
+	uint16_t *wtext;
+	size_t wtext_len;
+	int is_hash;
+	SceUInt32 hash;
+} RcoGrepQuery;
+
+int rco_grep_query_init(RcoGrepQuery *pQuery, const char *pattern);
+int rco_grep_query_fini(RcoGrepQuery *pQuery);
+
+/*
+ * Writes one "path: element @attribute = value" line per match to out and
+ * returns the number of matches, or < 0 if the file is broken. The tables
+ * are scanned first and the tree is only walked if one of them has a hit.
+ */
+int RcoGrep_core(OutBuffer *out, const char *path, const void *data, size_t size, const RcoGrepQuery *pQuery);
+
+/*
+ * Searches every file on nThread workers and prints the matches in the
+ * order of paths. Returns the number of matches, or < 0 if a file failed.
+ */
+int RcoGrep(const char * const *paths, int nPath, const char *pattern, int nThread);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_GREP_H_ */
@@ -0,0 +1,196 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include "rco_inflate.h"
+
+#if defined(RCO_USE_LIBDEFLATE)
+#include <pthread.h>
+#include <libdeflate.h>
+#endif
+
+
+#define RCO_INFLATE_CHUNK (0x40000)
+
+// Larger payloads are streamed so memory use stays bounded
+#define RCO_INFLATE_BUFFER_LIMIT (0x1000000)
+
+#if defined(RCO_USE_LIBDEFLATE)
+
+static pthread_key_t rco_inflate_key;
+static pthread_once_t rco_inflate_once = PTHREAD_ONCE_INIT;
+
+static void rco_inflate_free_decompressor(void *argp){
+	libdeflate_free_decompressor((struct libdeflate_decompressor *)argp);
+}
+
+static void rco_inflate_key_init(void){
+	pthread_key_create(&rco_inflate_key, rco_inflate_free_decompressor);
+}
+
+// One decompressor per thread, released when the thread exits
+static struct libdeflate_decompressor *rco_inflate_get_decompressor(void){
+
+	struct libdeflate_decompressor *d;
+
+	pthread_once(&rco_inflate_once, rco_inflate_key_init);
+
+	d = pthread_getspecific(rco_inflate_key);
+	if(d == NULL){
+		d = libdeflate_alloc_decompressor();
+		if(d != NULL){
+			pthread_setspecific(rco_inflate_key, d);
+		}
+	}
+
+	return d;
+}
+
+const char *rco_inflate_get_backend_name(void){
+	return "libdeflate";
+}
+
+int rco_inflate_buffer(void *dst, size_t *pDstSize, const void *src, size_t src_size){
+
+	enum libdeflate_result res;
+	struct libdeflate_decompressor *d;
+	size_t actual = 0;
+
+	d = rco_inflate_get_decompressor();
+	if(d == NULL){
+		return -1;
+	}
+
+	res = libdeflate_zlib_decompress(d, src, src_size, dst, *pDstSize, &actual);
+	if(res != LIBDEFLATE_SUCCESS){
+		if(res != LIBDEFLATE_INSUFFICIENT_SPACE){
+			printf("libdeflate decompress failed : 0x%X\n", res);
+		}
+
+		return -1;
+	}
+
+	*pDstSize = actual;
+
+	return 0;
+}
+
+#else
+
+const char *rco_inflate_get_backend_name(void){
+	return "zlib";
+}
+
+int rco_inflate_buffer(void *dst, size_t *pDstSize, const void *src, size_t src_size){
+
+	int res;
+	uLongf dst_size = *pDstSize;
+
+	res = uncompress(dst, &dst_size, src, src_size);
+	if(res != Z_OK){
+		printf("zlib uncompress failed : 0x%X\n", res);
+		return -1;
+	}
+
+	*pDstSize = dst_size;
+
+	return 0;
+}
+
+#endif
+
+static int rco_inflate_stream_to_file(FILE *fp, const void *src, size_t src_size, size_t *pWritten){
+
+	int res, zres;
+	z_stream stream;
+	unsigned char *chunk;
+	size_t total = 0;
+
+	chunk = malloc(RCO_INFLATE_CHUNK);
+	if(chunk == NULL){
+		return -1;
+	}
+
+	memset(&stream, 0, sizeof(stream));
+
+	zres = inflateInit(&stream);
+	if(zres != Z_OK){
+		printf("zlib inflateInit failed : 0x%X\n", zres);
+		free(chunk);
+		return -1;
+	}
+
+	stream.next_in  = (Bytef *)src;
+	stream.avail_in = src_size;
+
+	res = 0;
+
+	do {
+		stream.next_out  = chunk;
+		stream.avail_out = RCO_INFLATE_CHUNK;
+
+		zres = inflate(&stream, Z_NO_FLUSH);
+		if(zres != Z_OK && zres != Z_STREAM_END){
+			printf("zlib inflate failed : 0x%X\n", zres);
+			res = -1;
+			break;
+		}
+
+		size_t produced = RCO_INFLATE_CHUNK - stream.avail_out;
+
+		if(fwrite(chunk, 1, produced, fp) != produced){
+			res = -1;
+			break;
+		}
+
+		total += produced;
+
+		if(zres == Z_OK && produced == 0 && stream.avail_in == 0){
+			printf("zlib inflate failed : truncated data\n");
+			res = -1;
+			break;
+		}
+	} while(zres != Z_STREAM_END);
+
+	inflateEnd(&stream);
+	free(chunk);
+
+	*pWritten = total;
+
+	return res;
+}
+
+int rco_inflate_to_file(FILE *fp, const void *src, size_t src_size, size_t origsize, size_t *pWritten){
+
+#if defined(RCO_USE_LIBDEFLATE)
+	if(origsize <= RCO_INFLATE_BUFFER_LIMIT){
+		size_t size = origsize;
+		void *buffer = malloc((size != 0) ? size : 1);
+		if(buffer == NULL){
+			return -1;
+		}
+
+		if(rco_inflate_buffer(buffer, &size, src, src_size) >= 0){
+			int res = 0;
+
+			if(fwrite(buffer, 1, size, fp) != size){
+				res = -1;
+			}
+
+			free(buffer);
+			*pWritten = size;
+
+			return res;
+		}
+
+		// Bigger than origsize claims, zlib can still stream it
+		free(buffer);
+		rewind(fp);
+	}
+#else
+	(void)origsize;
+#endif
+
+	return rco_inflate_stream_to_file(fp, src, src_size, pWritten);
+}
@@ -0,0 +1,38 @@
+
+#ifndef _RCO_INFLATE_H_
+#define _RCO_INFLATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdio.h>
+#include <stddef.h>
+
+
+/*
+ * zlib is always available. When built with RCO_USE_LIBDEFLATE, libdeflate
+ * is used for whole-buffer decoding and zlib only streams the payloads that
+ * are too large to be decoded in one piece.
+ */
+const char *rco_inflate_get_backend_name(void);
+
+/*
+ * Inflates a zlib stream into dst. *pDstSize is the room in dst on entry and
+ * the number of bytes produced on return.
+ */
+int rco_inflate_buffer(void *dst, size_t *pDstSize, const void *src, size_t src_size);
+
+/*
+ * Inflates a zlib stream into fp. origsize is the expected size, used to
+ * pick the backend. *pWritten receives the number of bytes written.
+ */
+int rco_inflate_to_file(FILE *fp, const void *src, size_t src_size, size_t origsize, size_t *pWritten);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_INFLATE_H_ */
@@ -0,0 +1,302 @@
+#include <string.h>
+#include "rco_reader.h"
+
+
+// Points *pData at [offset, offset + size) of a table, if that is inside it
+static int rco_reader_table_range(const RcoReader *reader, SceInt32 table_offset, SceInt32 table_size, int64_t offset, int64_t size, const void **pData){
+
+	if(offset < 0 || size < 0 || offset > table_size || size > table_size - offset){
+		return -1;
+	}
+
+	*pData = reader->data + table_offset + offset;
+
+	return 0;
+}
+
+// Length of the string at offset, which has to end inside the table
+static int rco_reader_table_string(const RcoReader *reader, SceInt32 table_offset, SceInt32 table_size, int64_t offset, const char **pStr, size_t *pLen){
+
+	const char *str, *end;
+
+	if(offset < 0 || offset >= table_size){
+		return -1;
+	}
+
+	str = (const char *)(reader->data + table_offset + offset);
+
+	end = memchr(str, 0, table_size - offset);
+	if(end == NULL){
+		return -1;
+	}
+
+	*pStr = str;
+	*pLen = end - str;
+
+	return 0;
+}
+
+int rco_reader_open(RcoReader *reader, const void *data, size_t size){
+
+	const SceRcoHeader *pHeader = (const SceRcoHeader *)data;
+
+	memset(reader, 0, sizeof(*reader));
+
+	if(size < sizeof(SceRcoHeader) || size > INT32_MAX){
+		return -1;
+	}
+
+	if(memcmp(pHeader->magic, "RCOF", 4) == 0){
+		reader->is_rcs = 0;
+	}else if(memcmp(pHeader->magic, "RCSF", 4) == 0){
+		reader->is_rcs = 1;
+	}else{
+		return -1;
+	}
+
+	const SceInt32 *table = &(pHeader->tree_offset);
+
+	// tree, id, idhash, string, wstring, hash, intarray, floatarray and file, each offset then size
+	static const int table_align[9] = {4, 1, 1, 1, 2, 4, 4, 4, 1};
+
+	for(int i=0;i<9;i++){
+		SceInt32 table_offset = table[i * 2 + 0];
+		SceInt32 table_size   = table[i * 2 + 1];
+
+		if(table_size == 0){
+			continue;
+		}
+
+		if(table_offset < 0 || table_size < 0 || (size_t)table_offset > size || (size_t)table_size > size - table_offset){
+			return -1;
+		}
+
+		// Values are read in place, so the buffer has to be aligned too
+		if(((uintptr_t)data + table_offset) % table_align[i] != 0){
+			return -1;
+		}
+	}
+
+	reader->data   = (const uint8_t *)data;
+	reader->size   = size;
+	reader->header = pHeader;
+
+	return 0;
+}
+
+const SceRcoTreeHeader *rco_reader_get_element(const RcoReader *reader, int32_t offset){
+
+	const SceRcoTreeHeader *element;
+	const void *data;
+
+	if((offset & 3) != 0){
+		return NULL;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->tree_offset, reader->header->tree_size, offset, sizeof(SceRcoTreeHeader), &data) < 0){
+		return NULL;
+	}
+
+	element = (const SceRcoTreeHeader *)data;
+
+	if(element->num_attributes < 0 || rco_reader_table_range(reader, reader->header->tree_offset, reader->header->tree_size, (int64_t)offset + sizeof(SceRcoTreeHeader), (int64_t)sizeof(SceRcoAttribute) * element->num_attributes, &data) < 0){
+		return NULL;
+	}
+
+	return element;
+}
+
+const SceRcoAttribute *rco_reader_get_attribute(const RcoReader *reader, int32_t offset, int index){
+
+	const SceRcoTreeHeader *element = rco_reader_get_element(reader, offset);
+
+	if(element == NULL || index < 0 || index >= element->num_attributes){
+		return NULL;
+	}
+
+	return (const SceRcoAttribute *)(&(element[1])) + index;
+}
+
+int32_t rco_reader_get_root(const RcoReader *reader){
+
+	if(rco_reader_get_element(reader, 0) == NULL){
+		return -1;
+	}
+
+	return 0;
+}
+
+int32_t rco_reader_get_parent(const RcoReader *reader, int32_t offset){
+
+	const SceRcoTreeHeader *element = rco_reader_get_element(reader, offset);
+
+	if(element == NULL || element->parent_elm_offset < 0 || element->parent_elm_offset >= offset){
+		return -1;
+	}
+
+	if(rco_reader_get_element(reader, element->parent_elm_offset) == NULL){
+		return -1;
+	}
+
+	return element->parent_elm_offset;
+}
+
+int32_t rco_reader_get_first_child(const RcoReader *reader, int32_t offset){
+
+	const SceRcoTreeHeader *element = rco_reader_get_element(reader, offset);
+
+	if(element == NULL || element->first_child_elm_offset <= offset){
+		return -1;
+	}
+
+	if(rco_reader_get_element(reader, element->first_child_elm_offset) == NULL){
+		return -1;
+	}
+
+	return element->first_child_elm_offset;
+}
+
+int32_t rco_reader_get_next_sibling(const RcoReader *reader, int32_t offset){
+
+	const SceRcoTreeHeader *element = rco_reader_get_element(reader, offset);
+
+	if(element == NULL || element->next_elm_offset <= offset){
+		return -1;
+	}
+
+	if(rco_reader_get_element(reader, element->next_elm_offset) == NULL){
+		return -1;
+	}
+
+	return element->next_elm_offset;
+}
+
+int rco_reader_get_string(const RcoReader *reader, int32_t handle, const char **pStr, size_t *pLen){
+	return rco_reader_table_string(reader, reader->header->stringtable_offset, reader->header->stringtable_size, handle, pStr, pLen);
+}
+
+int rco_reader_get_wstring(const RcoReader *reader, const SceRcoAttribute *attr, const SceWChar16 **pStr, size_t *pLen){
+
+	const SceWChar16 *wstr;
+	int64_t count;
+	size_t len = 0;
+
+	if(attr->type != attr_type_wstring || attr->v1 < 0){
+		return -1;
+	}
+
+	count = reader->header->wstringtable_size / (int64_t)sizeof(SceWChar16) - attr->v1;
+	if(count <= 0){
+		return -1;
+	}
+
+	wstr = (const SceWChar16 *)(reader->data + reader->header->wstringtable_offset) + attr->v1;
+
+	while(wstr[len] != 0){
+		len++;
+		if((int64_t)len == count){
+			return -1;
+		}
+	}
+
+	*pStr = wstr;
+	*pLen = len;
+
+	return 0;
+}
+
+int rco_reader_get_hash(const RcoReader *reader, const SceRcoAttribute *attr, SceUInt32 *pHash){
+
+	const void *data;
+
+	if(attr->type != attr_type_hash || attr->v2 != 4){
+		return -1;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->hashtable_offset, reader->header->hashtable_size, (int64_t)attr->v1 * sizeof(SceUInt32), sizeof(SceUInt32), &data) < 0){
+		return -1;
+	}
+
+	*pHash = *(const SceUInt32 *)data;
+
+	return 0;
+}
+
+int rco_reader_get_intarray(const RcoReader *reader, const SceRcoAttribute *attr, const SceInt32 **pData, size_t *pCount){
+
+	const void *data;
+
+	if(attr->type != attr_type_intarray){
+		return -1;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->intarraytable_offset, reader->header->intarraytable_size, (int64_t)attr->v1 * sizeof(SceInt32), (int64_t)attr->v2 * sizeof(SceInt32), &data) < 0){
+		return -1;
+	}
+
+	*pData  = (const SceInt32 *)data;
+	*pCount = attr->v2;
+
+	return 0;
+}
+
+int rco_reader_get_floatarray(const RcoReader *reader, const SceRcoAttribute *attr, const float **pData, size_t *pCount){
+
+	const void *data;
+
+	if(attr->type != attr_type_floatarray){
+		return -1;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->floatarraytable_offset, reader->header->floatarraytable_size, (int64_t)attr->v1 * sizeof(float), (int64_t)attr->v2 * sizeof(float), &data) < 0){
+		return -1;
+	}
+
+	*pData  = (const float *)data;
+	*pCount = attr->v2;
+
+	return 0;
+}
+
+int rco_reader_get_file(const RcoReader *reader, const SceRcoAttribute *attr, const void **pData, size_t *pSize){
+
+	if(attr->type != attr_type_filename){
+		return -1;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->filetable_offset, reader->header->filetable_size, attr->v1, attr->v2, pData) < 0){
+		return -1;
+	}
+
+	*pSize = attr->v2;
+
+	return 0;
+}
+
+int rco_reader_get_id(const RcoReader *reader, const SceRcoAttribute *attr, const char **pStr, size_t *pLen){
+
+	if(attr->type != attr_type_id){
+		return -1;
+	}
+
+	// The entry is the offset of the element that owns it, then the string
+	return rco_reader_table_string(reader, reader->header->idtable_offset, reader->header->idtable_size, (int64_t)attr->v1 + 4, pStr, pLen);
+}
+
+int rco_reader_get_idhash(const RcoReader *reader, const SceRcoAttribute *attr, SceUInt32 *pHash){
+
+	const void *data;
+
+	if(attr->type != attr_type_idhash && attr->type != attr_type_idhashref){
+		return -1;
+	}
+
+	if(rco_reader_table_range(reader, reader->header->idhashtable_offset, reader->header->idhashtable_size, (int64_t)attr->v1 + 4, sizeof(SceUInt32), &data) < 0){
+		return -1;
+	}
+
+	// v1 is a byte offset, so the entry may not be aligned
+	memcpy(pHash, data, sizeof(*pHash));
+
+	return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef _RCO_READER_H_
+#define _RCO_READER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rco_format.h"
+
+
+/*
+ * Read-only access to an RCO or RCS that is already in memory. Nothing is
+ * allocated or copied: every value is a pointer into the buffer, which has
+ * to outlive the reader. Unlike the decompiler, every offset is checked
+ * against the buffer, so a broken file gives an error instead of a crash.
+ * Values are read in place, so the buffer has to be 4-byte aligned (a
+ * mapped file or malloc'd memory is).
+ */
+typedef struct RcoReader {
+	const uint8_t *data;
+	size_t size;
+	const SceRcoHeader *header;
+	int is_rcs; // RCSF rather than RCOF
+} RcoReader;
+
+int rco_reader_open(RcoReader *reader, const void *data, size_t size);
+
+/*
+ * Elements are named by their offset in the tree section. The links below
+ * return -1 when there is no such element or it is out of range. Children
+ * and next siblings must be stored after the element they follow, so walks
+ * over a broken file still end.
+ */
+int32_t rco_reader_get_root(const RcoReader *reader);
+int32_t rco_reader_get_parent(const RcoReader *reader, int32_t offset);
+int32_t rco_reader_get_first_child(const RcoReader *reader, int32_t offset);
+int32_t rco_reader_get_next_sibling(const RcoReader *reader, int32_t offset);
+
+// NULL if the element or its attributes do not fit in the tree section
+const SceRcoTreeHeader *rco_reader_get_element(const RcoReader *reader, int32_t offset);
+const SceRcoAttribute *rco_reader_get_attribute(const RcoReader *reader, int32_t offset, int index);
+
+// The value getters return -1 if the attribute has another type or points out of range
+int rco_reader_get_string(const RcoReader *reader, int32_t handle, const char **pStr, size_t *pLen);
+int rco_reader_get_wstring(const RcoReader *reader, const SceRcoAttribute *attr, const SceWChar16 **pStr, size_t *pLen);
+int rco_reader_get_hash(const RcoReader *reader, const SceRcoAttribute *attr, SceUInt32 *pHash);
+int rco_reader_get_intarray(const RcoReader *reader, const SceRcoAttribute *attr, const SceInt32 **pData, size_t *pCount);
+int rco_reader_get_floatarray(const RcoReader *reader, const SceRcoAttribute *attr, const float **pData, size_t *pCount);
+int rco_reader_get_file(const RcoReader *reader, const SceRcoAttribute *attr, const void **pData, size_t *pSize);
+int rco_reader_get_id(const RcoReader *reader, const SceRcoAttribute *attr, const char **pStr, size_t *pLen);
+int rco_reader_get_idhash(const RcoReader *reader, const SceRcoAttribute *attr, SceUInt32 *pHash); // idhash and idhashref
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_READER_H_ */
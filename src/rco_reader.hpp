@@ -0,0 +1,362 @@
+#ifndef _RCO_READER_HPP_
+#define _RCO_READER_HPP_
+
+/*
+ * Non-owning C++17 views over rco_reader.h. Nothing here allocates: names
+ * and values are string_views and spans into the buffer given to RcoFile,
+ * which has to outlive the file and every view taken from it. A view that
+ * does not point at anything is false, and a typed accessor called on an
+ * attribute of another type (or one that is out of range) gives nullopt.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include "rco_reader.h"
+
+
+namespace rco {
+
+template<typename T>
+class Span {
+public:
+	constexpr Span() noexcept : data_(nullptr), size_(0) {}
+	constexpr Span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+	constexpr T *data() const noexcept { return data_; }
+	constexpr std::size_t size() const noexcept { return size_; }
+	constexpr bool empty() const noexcept { return size_ == 0; }
+
+	constexpr T *begin() const noexcept { return data_; }
+	constexpr T *end() const noexcept { return data_ + size_; }
+	constexpr T &operator[](std::size_t index) const noexcept { return data_[index]; }
+
+private:
+	T *data_;
+	std::size_t size_;
+};
+
+class AttributeView {
+public:
+	AttributeView() noexcept : reader_(nullptr), attr_(nullptr) {}
+	AttributeView(const RcoReader *reader, const SceRcoAttribute *attr) noexcept : reader_(reader), attr_(attr) {}
+
+	explicit operator bool() const noexcept { return attr_ != nullptr; }
+
+	int type() const noexcept { return (attr_ != nullptr) ? attr_->type : 0; }
+
+	std::string_view name() const noexcept {
+		const char *str;
+		std::size_t len;
+
+		if(attr_ == nullptr || rco_reader_get_string(reader_, attr_->name_handle, &str, &len) < 0){
+			return std::string_view();
+		}
+
+		return std::string_view(str, len);
+	}
+
+	std::optional<std::int32_t> as_int() const noexcept {
+		if(type() != attr_type_int){
+			return std::nullopt;
+		}
+
+		return attr_->v1;
+	}
+
+	std::optional<float> as_float() const noexcept {
+		if(type() != attr_type_float){
+			return std::nullopt;
+		}
+
+		float value;
+		static_assert(sizeof(value) == sizeof(attr_->v1), "float is stored in v1");
+		std::memcpy(&value, &(attr_->v1), sizeof(value));
+
+		return value;
+	}
+
+	std::optional<std::string_view> as_string() const noexcept {
+		const char *str;
+		std::size_t len;
+
+		if(type() != attr_type_string || rco_reader_get_string(reader_, attr_->v1, &str, &len) < 0){
+			return std::nullopt;
+		}
+
+		return std::string_view(str, len);
+	}
+
+	std::optional<std::u16string_view> as_wstring() const noexcept {
+		const SceWChar16 *str;
+		std::size_t len;
+
+		if(attr_ == nullptr || rco_reader_get_wstring(reader_, attr_, &str, &len) < 0){
+			return std::nullopt;
+		}
+
+		return std::u16string_view(reinterpret_cast<const char16_t *>(str), len);
+	}
+
+	std::optional<std::uint32_t> as_hash() const noexcept {
+		SceUInt32 hash;
+
+		if(attr_ == nullptr || rco_reader_get_hash(reader_, attr_, &hash) < 0){
+			return std::nullopt;
+		}
+
+		return hash;
+	}
+
+	std::optional<Span<const std::int32_t>> as_intarray() const noexcept {
+		const SceInt32 *data;
+		std::size_t count;
+
+		if(attr_ == nullptr || rco_reader_get_intarray(reader_, attr_, &data, &count) < 0){
+			return std::nullopt;
+		}
+
+		return Span<const std::int32_t>(data, count);
+	}
+
+	std::optional<Span<const float>> as_floatarray() const noexcept {
+		const float *data;
+		std::size_t count;
+
+		if(attr_ == nullptr || rco_reader_get_floatarray(reader_, attr_, &data, &count) < 0){
+			return std::nullopt;
+		}
+
+		return Span<const float>(data, count);
+	}
+
+	// The payload as stored, so still compressed if the element says compress="on"
+	std::optional<Span<const std::uint8_t>> as_file() const noexcept {
+		const void *data;
+		std::size_t size;
+
+		if(attr_ == nullptr || rco_reader_get_file(reader_, attr_, &data, &size) < 0){
+			return std::nullopt;
+		}
+
+		return Span<const std::uint8_t>(static_cast<const std::uint8_t *>(data), size);
+	}
+
+	std::optional<std::string_view> as_id() const noexcept {
+		const char *str;
+		std::size_t len;
+
+		if(attr_ == nullptr || rco_reader_get_id(reader_, attr_, &str, &len) < 0){
+			return std::nullopt;
+		}
+
+		return std::string_view(str, len);
+	}
+
+	// idhash and idhashref
+	std::optional<std::uint32_t> as_idhash() const noexcept {
+		SceUInt32 hash;
+
+		if(attr_ == nullptr || rco_reader_get_idhash(reader_, attr_, &hash) < 0){
+			return std::nullopt;
+		}
+
+		return hash;
+	}
+
+	const SceRcoAttribute *get() const noexcept { return attr_; }
+
+private:
+	const RcoReader *reader_;
+	const SceRcoAttribute *attr_;
+};
+
+class AttributeIterator {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type        = AttributeView;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = void;
+	using reference         = AttributeView;
+
+	AttributeIterator(const RcoReader *reader, const SceRcoAttribute *attr) noexcept : reader_(reader), attr_(attr) {}
+
+	AttributeView operator*() const noexcept { return AttributeView(reader_, attr_); }
+	AttributeIterator &operator++() noexcept { attr_++; return *this; }
+	AttributeIterator operator++(int) noexcept { AttributeIterator prev = *this; attr_++; return prev; }
+
+	bool operator==(const AttributeIterator &other) const noexcept { return attr_ == other.attr_; }
+	bool operator!=(const AttributeIterator &other) const noexcept { return attr_ != other.attr_; }
+
+private:
+	const RcoReader *reader_;
+	const SceRcoAttribute *attr_;
+};
+
+class AttributeRange {
+public:
+	AttributeRange(const RcoReader *reader, const SceRcoAttribute *first, std::size_t count) noexcept : reader_(reader), first_(first), count_(count) {}
+
+	AttributeIterator begin() const noexcept { return AttributeIterator(reader_, first_); }
+	AttributeIterator end() const noexcept { return AttributeIterator(reader_, first_ + count_); }
+	std::size_t size() const noexcept { return count_; }
+
+private:
+	const RcoReader *reader_;
+	const SceRcoAttribute *first_;
+	std::size_t count_;
+};
+
+class ElementView;
+
+// Walks an element and the siblings after it
+class SiblingIterator {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type        = ElementView;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = void;
+	using reference         = ElementView;
+
+	SiblingIterator(const RcoReader *reader, std::int32_t offset) noexcept : reader_(reader), offset_(offset) {}
+
+	inline ElementView operator*() const noexcept;
+	SiblingIterator &operator++() noexcept { offset_ = rco_reader_get_next_sibling(reader_, offset_); return *this; }
+	SiblingIterator operator++(int) noexcept { SiblingIterator prev = *this; ++(*this); return prev; }
+
+	bool operator==(const SiblingIterator &other) const noexcept { return offset_ == other.offset_; }
+	bool operator!=(const SiblingIterator &other) const noexcept { return offset_ != other.offset_; }
+
+private:
+	const RcoReader *reader_;
+	std::int32_t offset_;
+};
+
+class SiblingRange {
+public:
+	SiblingRange(const RcoReader *reader, std::int32_t first) noexcept : reader_(reader), first_(first) {}
+
+	SiblingIterator begin() const noexcept { return SiblingIterator(reader_, first_); }
+	SiblingIterator end() const noexcept { return SiblingIterator(reader_, -1); }
+
+private:
+	const RcoReader *reader_;
+	std::int32_t first_;
+};
+
+class ElementView {
+public:
+	ElementView() noexcept : reader_(nullptr), offset_(-1) {}
+	ElementView(const RcoReader *reader, std::int32_t offset) noexcept : reader_(reader), offset_(offset) {}
+
+	explicit operator bool() const noexcept { return offset_ >= 0; }
+
+	// Offset in the tree section, the same for every view of this element
+	std::int32_t offset() const noexcept { return offset_; }
+
+	std::string_view name() const noexcept {
+		const SceRcoTreeHeader *element = header();
+		const char *str;
+		std::size_t len;
+
+		if(element == nullptr || rco_reader_get_string(reader_, element->name_handle, &str, &len) < 0){
+			return std::string_view();
+		}
+
+		return std::string_view(str, len);
+	}
+
+	ElementView parent() const noexcept { return link(rco_reader_get_parent); }
+	ElementView first_child() const noexcept { return link(rco_reader_get_first_child); }
+	ElementView next_sibling() const noexcept { return link(rco_reader_get_next_sibling); }
+
+	SiblingRange children() const noexcept {
+		return SiblingRange(reader_, (offset_ >= 0) ? rco_reader_get_first_child(reader_, offset_) : -1);
+	}
+
+	// This element and the ones after it
+	SiblingRange siblings() const noexcept { return SiblingRange(reader_, offset_); }
+
+	AttributeRange attributes() const noexcept {
+		const SceRcoTreeHeader *element = header();
+
+		if(element == nullptr){
+			return AttributeRange(reader_, nullptr, 0);
+		}
+
+		return AttributeRange(reader_, reinterpret_cast<const SceRcoAttribute *>(element + 1), element->num_attributes);
+	}
+
+	// The first attribute with this name, or a false view
+	AttributeView attribute(std::string_view name) const noexcept {
+		for(AttributeView attr : attributes()){
+			if(attr.name() == name){
+				return attr;
+			}
+		}
+
+		return AttributeView();
+	}
+
+	ElementView child(std::string_view name) const noexcept {
+		for(ElementView element : children()){
+			if(element.name() == name){
+				return element;
+			}
+		}
+
+		return ElementView();
+	}
+
+	const SceRcoTreeHeader *header() const noexcept {
+		return (offset_ >= 0) ? rco_reader_get_element(reader_, offset_) : nullptr;
+	}
+
+private:
+	ElementView link(std::int32_t (*get)(const RcoReader *, std::int32_t)) const noexcept {
+		if(offset_ < 0){
+			return ElementView();
+		}
+
+		return ElementView(reader_, get(reader_, offset_));
+	}
+
+	const RcoReader *reader_;
+	std::int32_t offset_;
+};
+
+inline ElementView SiblingIterator::operator*() const noexcept {
+	return ElementView(reader_, offset_);
+}
+
+// Views keep a pointer to the file, so it cannot be copied or moved
+class RcoFile {
+public:
+	RcoFile(const void *data, std::size_t size) noexcept {
+		is_open_ = rco_reader_open(&reader_, data, size) >= 0;
+	}
+
+	RcoFile(const RcoFile &) = delete;
+	RcoFile &operator=(const RcoFile &) = delete;
+
+	explicit operator bool() const noexcept { return is_open_; }
+
+	bool is_rcs() const noexcept { return is_open_ && reader_.is_rcs != 0; }
+
+	ElementView root() const noexcept {
+		return ElementView(&reader_, is_open_ ? rco_reader_get_root(&reader_) : -1);
+	}
+
+	const RcoReader *get() const noexcept { return &reader_; }
+
+private:
+	RcoReader reader_;
+	bool is_open_;
+};
+
+} // namespace rco
+
+#endif /* _RCO_READER_HPP_ */
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "arena.h"
+#include "hash_table.h"
+#include "rco_decompiler.h"
+#include "file_util.h"
+#include "rco_schema.h"
+
+
+struct RcoSchemaEntry {
+	struct RcoSchemaEntry *next;
+	const char *element;
+	const char *key;
+	int type;
+};
+
+typedef struct RcoSchemaKey {
+	const char *element;
+	const char *key;
+} RcoSchemaKey;
+
+// Index is attr_type_*
+static const char *rco_schema_type_names[] = {
+	NULL, "int", "float", "string", "wstring", "hash", "intarray", "floatarray", "filename", "id", "idref", "idhash", "idhashref"
+};
+
+#define RCO_SCHEMA_TYPE_MAX ((int)(sizeof(rco_schema_type_names) / sizeof(rco_schema_type_names[0])))
+
+// Used when a pair is not in the schema. element NULL matches any element.
+static const struct {
+	const char *element;
+	const char *key;
+	int type;
+} rco_schema_defaults[] = {
+	{"locale",    "id",       attr_type_id},
+	{"locale",    "src",      attr_type_filename},
+	{"texture",   "id",       attr_type_idhash},
+	{"texture",   "src",      attr_type_filename},
+	{"file",      "id",       attr_type_idhash},
+	{"file",      "src",      attr_type_filename},
+	{"sounddata", "id",       attr_type_idhash},
+	{"sounddata", "src",      attr_type_filename},
+	{"text",      "id",       attr_type_id},
+	{"text",      "src",      attr_type_wstring},
+	{NULL,        "type",     attr_type_string},
+	{NULL,        "compress", attr_type_string},
+	{NULL,        "origsize", attr_type_int},
+};
+
+static uint64_t rco_schema_hash(const char *element, const char *key){
+	return hash_table_hash_bytes(key, strlen(key), hash_table_hash_bytes(element, strlen(element), 0));
+}
+
+static int rco_schema_match(const void *value, const void *key){
+
+	const RcoSchemaEntry *entry = (const RcoSchemaEntry *)value;
+	const RcoSchemaKey *schema_key = (const RcoSchemaKey *)key;
+
+	return strcmp(entry->element, schema_key->element) == 0 && strcmp(entry->key, schema_key->key) == 0;
+}
+
+int rco_schema_init(RcoSchema *pSchema){
+
+	memset(pSchema, 0, sizeof(*pSchema));
+
+	arena_init(&(pSchema->arena), 0x4000);
+
+	pSchema->tail = &(pSchema->head);
+
+	return hash_table_init(&(pSchema->table), 0x100);
+}
+
+int rco_schema_fini(RcoSchema *pSchema){
+
+	hash_table_fini(&(pSchema->table));
+	arena_fini(&(pSchema->arena));
+
+	pSchema->head = NULL;
+	pSchema->tail = &(pSchema->head);
+
+	return 0;
+}
+
+int rco_schema_set(RcoSchema *pSchema, const char *element, const char *key, int type){
+
+	RcoSchemaKey schema_key;
+	RcoSchemaEntry *entry;
+	uint64_t hash;
+
+	schema_key.element = element;
+	schema_key.key     = key;
+
+	hash = rco_schema_hash(element, key);
+
+	entry = hash_table_find(&(pSchema->table), hash, rco_schema_match, &schema_key);
+	if(entry != NULL){
+		if(entry->type != type){
+			pSchema->nConflict++;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	entry = arena_alloc(&(pSchema->arena), sizeof(*entry));
+	if(entry == NULL){
+		return -1;
+	}
+
+	entry->next    = NULL;
+	entry->element = arena_strndup(&(pSchema->arena), element, strlen(element));
+	entry->key     = arena_strndup(&(pSchema->arena), key, strlen(key));
+	entry->type    = type;
+
+	if(entry->element == NULL || entry->key == NULL){
+		return -1;
+	}
+
+	*(pSchema->tail) = entry;
+	pSchema->tail = &(entry->next);
+
+	return hash_table_insert(&(pSchema->table), hash, entry);
+}
+
+int rco_schema_get(const RcoSchema *pSchema, const char *element, const char *key){
+
+	RcoSchemaKey schema_key;
+	const RcoSchemaEntry *entry;
+
+	schema_key.element = element;
+	schema_key.key     = key;
+
+	entry = hash_table_find(&(pSchema->table), rco_schema_hash(element, key), rco_schema_match, &schema_key);
+	if(entry == NULL){
+		return 0;
+	}
+
+	return entry->type;
+}
+
+int rco_schema_load(RcoSchema *pSchema, const char *path){
+
+	FILE *fp;
+	char line[0x200], element[0x80], key[0x80], type_name[0x20];
+	int res = 0, line_number = 0;
+
+	fp = fopen(path, "r");
+	if(fp == NULL){
+		return 1;
+	}
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		line_number++;
+
+		if(line[0] == '#' || line[0] == '\n'){
+			continue;
+		}
+
+		if(sscanf(line, "%127s %127s %31s", element, key, type_name) != 3){
+			printf("%s:%d: expected \"element attribute type\"\n", path, line_number);
+			res = -1;
+			break;
+		}
+
+		int type = rco_schema_get_type_by_name(type_name);
+		if(type <= 0){
+			printf("%s:%d: unknown type \"%s\"\n", path, line_number, type_name);
+			res = -1;
+			break;
+		}
+
+		if(rco_schema_set(pSchema, element, key, type) < 0){
+			res = -1;
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	return res;
+}
+
+int rco_schema_save(const RcoSchema *pSchema, const char *path){
+
+	FILE *fp;
+	int res = 0;
+
+	// Next to the XML, so possibly a hardlink into the cache
+	fp = create_output_file(path);
+	if(fp == NULL){
+		return -1;
+	}
+
+	fprintf(fp, "# element attribute type\n");
+
+	for(const RcoSchemaEntry *entry=pSchema->head;entry!=NULL;entry=entry->next){
+		fprintf(fp, "%s %s %s\n", entry->element, entry->key, rco_schema_get_type_name(entry->type));
+	}
+
+	if(ferror(fp) != 0){
+		res = -1;
+	}
+
+	if(fclose(fp) != 0){
+		res = -1;
+	}
+
+	return res;
+}
+
+static int rco_schema_is_int(const char *value){
+
+	if(*value == '-'){
+		value++;
+	}
+
+	if(*value == 0){
+		return 0;
+	}
+
+	while(*value != 0){
+		if(isdigit((unsigned char)*value) == 0){
+			return 0;
+		}
+
+		value++;
+	}
+
+	return 1;
+}
+
+static int rco_schema_is_float(const char *value){
+
+	char *end;
+
+	if(*value == 0){
+		return 0;
+	}
+
+	strtod(value, &end);
+
+	return *end == 0;
+}
+
+int rco_schema_guess(const char *element, const char *key, const char *value){
+
+	for(size_t i=0;i<sizeof(rco_schema_defaults)/sizeof(rco_schema_defaults[0]);i++){
+		if(strcmp(rco_schema_defaults[i].key, key) != 0){
+			continue;
+		}
+
+		if(rco_schema_defaults[i].element == NULL || strcmp(rco_schema_defaults[i].element, element) == 0){
+			return rco_schema_defaults[i].type;
+		}
+	}
+
+	// Hashes are the only values printed as 0x%08X
+	if(strlen(value) == 10 && value[0] == '0' && value[1] == 'x' && strspn(&(value[2]), "0123456789ABCDEF") == 8){
+		return (strcmp(key, "id") == 0) ? attr_type_idhash : attr_type_hash;
+	}
+
+	if(rco_schema_is_int(value) != 0){
+		return attr_type_int;
+	}
+
+	if(rco_schema_is_float(value) != 0){
+		return attr_type_float;
+	}
+
+	if(strstr(value, ", ") != NULL){
+		int is_float = 0;
+		const char *p = value;
+
+		while(*p != 0){
+			if(strchr("0123456789-, ", *p) == NULL){
+				if(strchr(".eEinfa", *p) == NULL){
+					return attr_type_string;
+				}
+
+				is_float = 1;
+			}
+
+			p++;
+		}
+
+		return (is_float != 0) ? attr_type_floatarray : attr_type_intarray;
+	}
+
+	return attr_type_string;
+}
+
+const char *rco_schema_get_type_name(int type){
+
+	if(type <= 0 || type >= RCO_SCHEMA_TYPE_MAX){
+		return "unknown";
+	}
+
+	return rco_schema_type_names[type];
+}
+
+int rco_schema_get_type_by_name(const char *name){
+
+	for(int i=1;i<RCO_SCHEMA_TYPE_MAX;i++){
+		if(strcmp(rco_schema_type_names[i], name) == 0){
+			return i;
+		}
+	}
+
+	return 0;
+}
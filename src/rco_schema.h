@@ -0,0 +1,53 @@
+
+#ifndef _RCO_SCHEMA_H_
+#define _RCO_SCHEMA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "arena.h"
+#include "hash_table.h"
+
+
+typedef struct RcoSchemaEntry RcoSchemaEntry;
+
+/*
+ * The XML does not say which attr_type_* a value had. A schema maps
+ * (element name, attribute name) to it, so the compiler can rebuild the
+ * same types. The decompiler writes one with --schema.
+ */
+typedef struct RcoSchema {
+	Arena arena;
+	HashTable table;
+	RcoSchemaEntry *head; // in insertion order, for saving
+	RcoSchemaEntry **tail;
+	int nConflict;
+} RcoSchema;
+
+int rco_schema_init(RcoSchema *pSchema);
+int rco_schema_fini(RcoSchema *pSchema);
+
+// The first type set for a pair is kept, later different ones count as conflicts
+int rco_schema_set(RcoSchema *pSchema, const char *element, const char *key, int type);
+
+// 0 if the pair is not in the schema
+int rco_schema_get(const RcoSchema *pSchema, const char *element, const char *key);
+
+// Returns 1 if path does not exist, <0 on error
+int rco_schema_load(RcoSchema *pSchema, const char *path);
+int rco_schema_save(const RcoSchema *pSchema, const char *path);
+
+// Type of an attribute that is not in the schema, from well-known names and the value
+int rco_schema_guess(const char *element, const char *key, const char *value);
+
+const char *rco_schema_get_type_name(int type);
+int rco_schema_get_type_by_name(const char *name);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_SCHEMA_H_ */
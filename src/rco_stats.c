@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "rco_stats.h"
+
+
+static const char *rco_stats_time_names[RCO_STATS_TIME_MAX] = {
+	"total", "read", "parse", "print", "inflate", "inflate_stream", "write", "locale", "wait"
+};
+
+static const char *rco_stats_count_names[RCO_STATS_COUNT_MAX] = {
+	"elements", "attributes", "payloads", "payload_bytes_in", "payload_bytes_out", "files_written", "files_linked"
+};
+
+// Index is attr_type_*, 0 is unused
+static const char *rco_stats_attr_type_names[RCO_STATS_ATTR_TYPE_MAX] = {
+	NULL, "int", "float", "string", "wstring", "hash", "intarray", "floatarray", "filename", "id", "idref", "idhash", "idhashref"
+};
+
+uint64_t rco_stats_now(void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t rco_stats_start(const RcoStats *pStats){
+
+	if(pStats == NULL){
+		return 0;
+	}
+
+	return rco_stats_now();
+}
+
+void rco_stats_add_time(RcoStats *pStats, int timer, uint64_t start){
+
+	if(pStats == NULL){
+		return;
+	}
+
+	__atomic_fetch_add(&(pStats->time_ns[timer]), rco_stats_now() - start, __ATOMIC_RELAXED);
+}
+
+void rco_stats_add_count(RcoStats *pStats, int counter, uint64_t value){
+
+	if(pStats == NULL){
+		return;
+	}
+
+	__atomic_fetch_add(&(pStats->count[counter]), value, __ATOMIC_RELAXED);
+}
+
+void rco_stats_add_attr_type(RcoStats *pStats, int type, uint64_t value){
+
+	if(pStats == NULL || type <= 0 || type >= RCO_STATS_ATTR_TYPE_MAX){
+		return;
+	}
+
+	__atomic_fetch_add(&(pStats->attr_type[type]), value, __ATOMIC_RELAXED);
+}
+
+static void rco_stats_write_json_string(FILE *fp, const char *str){
+
+	fputc('"', fp);
+
+	while(*str != 0){
+		unsigned char c = (unsigned char)*str++;
+
+		if(c == '"' || c == '\\'){
+			fputc('\\', fp);
+			fputc(c, fp);
+		}else if(c < 0x20){
+			fprintf(fp, "\\u%04X", c);
+		}else{
+			fputc(c, fp);
+		}
+	}
+
+	fputc('"', fp);
+}
+
+int rco_stats_write_json(FILE *fp, const char *input, int result, const RcoStats *pStats){
+
+	int res;
+
+	// Batch workers share fp, keep each line in one piece
+	flockfile(fp);
+
+	fputs("{\"input\":", fp);
+	rco_stats_write_json_string(fp, input);
+	fprintf(fp, ",\"result\":%d,\"cached\":%s,\"time_ms\":{", result, (pStats->cached != 0) ? "true" : "false");
+
+	for(int i=0;i<RCO_STATS_TIME_MAX;i++){
+		fprintf(fp, "%s\"%s\":%.3f", (i != 0) ? "," : "", rco_stats_time_names[i], (double)pStats->time_ns[i] / 1000000.0);
+	}
+
+	fputc('}', fp);
+
+	for(int i=0;i<RCO_STATS_COUNT_MAX;i++){
+		fprintf(fp, ",\"%s\":%llu", rco_stats_count_names[i], (unsigned long long)pStats->count[i]);
+	}
+
+	fputs(",\"attribute_types\":{", fp);
+
+	for(int i=1;i<RCO_STATS_ATTR_TYPE_MAX;i++){
+		fprintf(fp, "%s\"%s\":%llu", (i != 1) ? "," : "", rco_stats_attr_type_names[i], (unsigned long long)pStats->attr_type[i]);
+	}
+
+	fputs("}}\n", fp);
+
+	res = fflush(fp);
+
+	funlockfile(fp);
+
+	return (res != 0) ? -1 : 0;
+}
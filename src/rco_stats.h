@@ -0,0 +1,73 @@
+
+#ifndef _RCO_STATS_H_
+#define _RCO_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+/*
+ * Phases are exclusive of each other, except that PRINT includes the payload
+ * work done inline on the printing thread: all of it when there is no pool
+ * (each input of a batch), and io_uring batches flushed while printing. That
+ * work is counted under its own phase as well. Times spent on workers are
+ * summed over all of them, so they can add up to more than the total.
+ */
+enum {
+	RCO_STATS_TIME_TOTAL = 0,
+	RCO_STATS_TIME_READ,           // mapping or reading the input
+	RCO_STATS_TIME_PARSE,          // parse_element of the RCO tree
+	RCO_STATS_TIME_PRINT,          // print_cxml of the RCO tree, XML writes and inline payloads included
+	RCO_STATS_TIME_INFLATE,        // in-memory inflate of payloads
+	RCO_STATS_TIME_INFLATE_STREAM, // payloads inflated straight to their file, writes included
+	RCO_STATS_TIME_WRITE,          // payload and .rcs files written as stored, duplicates linked
+	RCO_STATS_TIME_LOCALE,         // locale RCS decompiled to XML
+	RCO_STATS_TIME_WAIT,           // waiting for the workers after printing
+	RCO_STATS_TIME_MAX
+};
+
+enum {
+	RCO_STATS_ELEMENTS = 0,
+	RCO_STATS_ATTRIBUTES,
+	RCO_STATS_PAYLOADS,
+	RCO_STATS_PAYLOAD_BYTES_IN,  // as stored in the input
+	RCO_STATS_PAYLOAD_BYTES_OUT, // as written, after inflate
+	RCO_STATS_FILES_WRITTEN,
+	RCO_STATS_FILES_LINKED,
+	RCO_STATS_COUNT_MAX
+};
+
+#define RCO_STATS_ATTR_TYPE_MAX (13)
+
+typedef struct RcoStats {
+	uint64_t time_ns[RCO_STATS_TIME_MAX];
+	uint64_t count[RCO_STATS_COUNT_MAX];
+	uint64_t attr_type[RCO_STATS_ATTR_TYPE_MAX]; // by attr_type_*, elements and attributes of the locale RCS included
+	int cached;
+} RcoStats;
+
+uint64_t rco_stats_now(void);
+
+/*
+ * All of these accept pStats == NULL and then do nothing. Updates are
+ * atomic, so payload workers can share one RcoStats.
+ */
+uint64_t rco_stats_start(const RcoStats *pStats);
+void rco_stats_add_time(RcoStats *pStats, int timer, uint64_t start);
+void rco_stats_add_count(RcoStats *pStats, int counter, uint64_t value);
+void rco_stats_add_attr_type(RcoStats *pStats, int type, uint64_t value);
+
+// One JSON object on a single line
+int rco_stats_write_json(FILE *fp, const char *input, int result, const RcoStats *pStats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_STATS_H_ */
@@ -0,0 +1,588 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+#include "hash_table.h"
+#include "rco_decompiler.h"
+#include "rco_writer.h"
+
+
+enum {
+	RCO_WRITER_TABLE_ID = 0,
+	RCO_WRITER_TABLE_IDHASH,
+	RCO_WRITER_TABLE_STRING,
+	RCO_WRITER_TABLE_WSTRING,
+	RCO_WRITER_TABLE_HASH,
+	RCO_WRITER_TABLE_INTARRAY,
+	RCO_WRITER_TABLE_FLOATARRAY,
+	RCO_WRITER_TABLE_FILE,
+	RCO_WRITER_TABLE_MAX
+};
+
+typedef struct RcoWriterTable {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+} RcoWriterTable;
+
+typedef struct RcoWriterAttribute {
+	struct RcoWriterAttribute *next;
+	SceInt32 name_handle;
+	SceInt32 type;
+	SceInt32 v1;
+	SceInt32 v2;
+} RcoWriterAttribute;
+
+struct RcoWriterElement {
+	RcoWriterElement *parent;
+	RcoWriterElement *child;
+	RcoWriterElement *last_child;
+	RcoWriterElement *prev;
+	RcoWriterElement *next;
+	SceInt32 name_handle;
+	int nAttribute;
+	RcoWriterAttribute *attr;
+	RcoWriterAttribute **attr_tail;
+	SceInt32 offset; // in the tree table, known after layout
+};
+
+// id and idhash entries start with the offset of their element
+typedef struct RcoWriterFixup {
+	struct RcoWriterFixup *next;
+	int table;
+	size_t offset;
+	RcoWriterElement *element;
+} RcoWriterFixup;
+
+typedef struct RcoWriterInternKey {
+	const RcoWriterTable *table;
+	size_t prefix_size;
+	const void *data;
+	size_t size;
+} RcoWriterInternKey;
+
+typedef struct RcoWriterInternEntry {
+	size_t offset; // of the entry, the data follows the prefix
+	size_t size;
+} RcoWriterInternEntry;
+
+struct RcoWriter {
+	Arena arena;
+	RcoWriterElement *root;
+	RcoWriterElement *last_root;
+	RcoWriterTable tables[RCO_WRITER_TABLE_MAX];
+	HashTable intern[RCO_WRITER_TABLE_MAX];
+	RcoWriterFixup *fixups;
+};
+
+
+int rco_writer_create(RcoWriter **ppWriter){
+
+	RcoWriter *pWriter;
+
+	pWriter = malloc(sizeof(*pWriter));
+	if(pWriter == NULL){
+		return -1;
+	}
+
+	memset(pWriter, 0, sizeof(*pWriter));
+
+	arena_init(&(pWriter->arena), 0);
+
+	for(int i=0;i<RCO_WRITER_TABLE_MAX;i++){
+		if(hash_table_init(&(pWriter->intern[i]), 0x100) < 0){
+			rco_writer_destroy(pWriter);
+			return -1;
+		}
+	}
+
+	*ppWriter = pWriter;
+
+	return 0;
+}
+
+int rco_writer_destroy(RcoWriter *pWriter){
+
+	if(pWriter == NULL){
+		return -1;
+	}
+
+	for(int i=0;i<RCO_WRITER_TABLE_MAX;i++){
+		hash_table_fini(&(pWriter->intern[i]));
+		free(pWriter->tables[i].data);
+	}
+
+	arena_fini(&(pWriter->arena));
+	free(pWriter);
+
+	return 0;
+}
+
+int rco_writer_table_reserve(RcoWriterTable *table, size_t size){
+
+	if(table->size + size <= table->capacity){
+		return 0;
+	}
+
+	size_t capacity = (table->capacity == 0) ? 0x1000 : table->capacity;
+	while(capacity < table->size + size){
+		capacity *= 2;
+	}
+
+	uint8_t *data = realloc(table->data, capacity);
+	if(data == NULL){
+		return -1;
+	}
+
+	table->data     = data;
+	table->capacity = capacity;
+
+	return 0;
+}
+
+int rco_writer_intern_match(const void *value, const void *key){
+
+	const RcoWriterInternEntry *entry = (const RcoWriterInternEntry *)value;
+	const RcoWriterInternKey *intern_key = (const RcoWriterInternKey *)key;
+
+	if(entry->size != intern_key->size){
+		return 0;
+	}
+
+	return memcmp(intern_key->table->data + entry->offset + intern_key->prefix_size, intern_key->data, entry->size) == 0;
+}
+
+/*
+ * Appends prefix, data and zero_pad zero bytes, padded up to align, unless
+ * an entry with the same data is already in the table. Only data is
+ * compared, the prefix belongs to the first entry. Returns the offset of
+ * the entry in bytes; *pIsNew tells which case it was.
+ */
+SceInt32 rco_writer_intern(RcoWriter *pWriter, int table_index, const void *prefix, size_t prefix_size, const void *data, size_t size, size_t zero_pad, size_t align, int *pIsNew){
+
+	RcoWriterTable *table = &(pWriter->tables[table_index]);
+	HashTable *intern = &(pWriter->intern[table_index]);
+	RcoWriterInternKey key;
+	RcoWriterInternEntry *entry;
+	uint64_t hash;
+	size_t offset, padded;
+
+	key.table       = table;
+	key.prefix_size = prefix_size;
+	key.data        = data;
+	key.size        = size;
+
+	hash = hash_table_hash_bytes(data, size, table_index);
+
+	entry = hash_table_find(intern, hash, rco_writer_intern_match, &key);
+	if(entry != NULL){
+		if(pIsNew != NULL){
+			*pIsNew = 0;
+		}
+
+		return (SceInt32)entry->offset;
+	}
+
+	offset = table->size;
+	padded = (prefix_size + size + zero_pad + (align - 1)) & ~(align - 1);
+
+	if(rco_writer_table_reserve(table, padded) < 0){
+		return -1;
+	}
+
+	if(prefix_size != 0){
+		memcpy(table->data + offset, prefix, prefix_size);
+	}
+
+	if(size != 0){
+		memcpy(table->data + offset + prefix_size, data, size);
+	}
+
+	memset(table->data + offset + prefix_size + size, 0, padded - (prefix_size + size));
+
+	table->size += padded;
+
+	entry = arena_alloc(&(pWriter->arena), sizeof(*entry));
+	if(entry == NULL){
+		return -1;
+	}
+
+	entry->offset = offset;
+	entry->size   = size;
+
+	if(hash_table_insert(intern, hash, entry) < 0){
+		return -1;
+	}
+
+	if(pIsNew != NULL){
+		*pIsNew = 1;
+	}
+
+	return (SceInt32)offset;
+}
+
+SceInt32 rco_writer_intern_string(RcoWriter *pWriter, const char *str){
+	return rco_writer_intern(pWriter, RCO_WRITER_TABLE_STRING, NULL, 0, str, strlen(str), 1, 1, NULL);
+}
+
+RcoWriterElement *rco_writer_add_element(RcoWriter *pWriter, RcoWriterElement *parent, const char *name){
+
+	RcoWriterElement *elm;
+
+	elm = arena_alloc(&(pWriter->arena), sizeof(*elm));
+	if(elm == NULL){
+		return NULL;
+	}
+
+	memset(elm, 0, sizeof(*elm));
+
+	elm->name_handle = rco_writer_intern_string(pWriter, name);
+	if(elm->name_handle < 0){
+		return NULL;
+	}
+
+	elm->parent    = parent;
+	elm->attr_tail = &(elm->attr);
+	elm->offset    = -1;
+
+	if(parent == NULL){
+		elm->prev = pWriter->last_root;
+		if(pWriter->last_root != NULL){
+			pWriter->last_root->next = elm;
+		}else{
+			pWriter->root = elm;
+		}
+
+		pWriter->last_root = elm;
+	}else{
+		elm->prev = parent->last_child;
+		if(parent->last_child != NULL){
+			parent->last_child->next = elm;
+		}else{
+			parent->child = elm;
+		}
+
+		parent->last_child = elm;
+	}
+
+	return elm;
+}
+
+RcoWriterElement *rco_writer_element_get_parent(const RcoWriterElement *elm){
+	return elm->parent;
+}
+
+int rco_writer_add_attribute(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, int type, SceInt32 v1, SceInt32 v2){
+
+	RcoWriterAttribute *attr;
+
+	attr = arena_alloc(&(pWriter->arena), sizeof(*attr));
+	if(attr == NULL){
+		return -1;
+	}
+
+	attr->next        = NULL;
+	attr->name_handle = rco_writer_intern_string(pWriter, key);
+	attr->type        = type;
+	attr->v1          = v1;
+	attr->v2          = v2;
+
+	if(attr->name_handle < 0){
+		return -1;
+	}
+
+	*(elm->attr_tail) = attr;
+	elm->attr_tail = &(attr->next);
+	elm->nAttribute++;
+
+	return 0;
+}
+
+int rco_writer_add_fixup(RcoWriter *pWriter, RcoWriterElement *elm, int table, SceInt32 offset){
+
+	RcoWriterFixup *fixup;
+
+	fixup = arena_alloc(&(pWriter->arena), sizeof(*fixup));
+	if(fixup == NULL){
+		return -1;
+	}
+
+	fixup->next    = pWriter->fixups;
+	fixup->table   = table;
+	fixup->offset  = offset;
+	fixup->element = elm;
+
+	pWriter->fixups = fixup;
+
+	return 0;
+}
+
+int rco_writer_add_int(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, int32_t value){
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_int, value, 0);
+}
+
+int rco_writer_add_float(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, float value){
+
+	SceInt32 v1;
+
+	memcpy(&v1, &value, sizeof(v1));
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_float, v1, 0);
+}
+
+int rco_writer_add_string(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const char *str){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern_string(pWriter, str);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_string, offset, strlen(str));
+}
+
+int rco_writer_add_wstring(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const uint16_t *wstr, int len){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_WSTRING, NULL, 0, wstr, len * sizeof(SceWChar16), sizeof(SceWChar16), sizeof(SceWChar16), NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_wstring, offset >> 1, len);
+}
+
+int rco_writer_add_hash(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_HASH, NULL, 0, &value, sizeof(value), 0, 4, NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_hash, offset >> 2, 4);
+}
+
+int rco_writer_add_intarray(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const int32_t *data, int count){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_INTARRAY, NULL, 0, data, count * sizeof(*data), 0, 4, NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_intarray, offset >> 2, count);
+}
+
+int rco_writer_add_floatarray(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const float *data, int count){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_FLOATARRAY, NULL, 0, data, count * sizeof(*data), 0, 4, NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_floatarray, offset >> 2, count);
+}
+
+int rco_writer_add_file(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const void *data, int size){
+
+	SceInt32 offset;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_FILE, NULL, 0, data, size, 0, 0x10, NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_filename, offset, size);
+}
+
+int rco_writer_add_id(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const char *id){
+
+	SceInt32 elm_offset = -1, offset;
+	size_t len = strlen(id);
+	int is_new;
+
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_ID, &elm_offset, sizeof(elm_offset), id, len, 1, 4, &is_new);
+	if(offset < 0){
+		return -1;
+	}
+
+	// The first element with this id owns the entry
+	if(is_new != 0 && rco_writer_add_fixup(pWriter, elm, RCO_WRITER_TABLE_ID, offset) < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_id, offset, len);
+}
+
+int rco_writer_add_idref(RcoWriter *pWriter, RcoWriterElement *elm, const char *key){
+	return rco_writer_add_attribute(pWriter, elm, key, attr_type_idref, -1, 0);
+}
+
+int rco_writer_add_idhash_entry(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, int type, uint32_t value){
+
+	SceInt32 elm_offset = -1, offset;
+
+	// A reference shares the entry of its definition, wherever that comes
+	offset = rco_writer_intern(pWriter, RCO_WRITER_TABLE_IDHASH, &elm_offset, sizeof(elm_offset), &value, sizeof(value), 0, 4, NULL);
+	if(offset < 0){
+		return -1;
+	}
+
+	if(type == attr_type_idhash && rco_writer_add_fixup(pWriter, elm, RCO_WRITER_TABLE_IDHASH, offset) < 0){
+		return -1;
+	}
+
+	return rco_writer_add_attribute(pWriter, elm, key, type, offset, 0);
+}
+
+int rco_writer_add_idhash(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value){
+	return rco_writer_add_idhash_entry(pWriter, elm, key, attr_type_idhash, value);
+}
+
+int rco_writer_add_idhashref(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value){
+	return rco_writer_add_idhash_entry(pWriter, elm, key, attr_type_idhashref, value);
+}
+
+#define RCO_WRITER_ALIGN(x) (((x) + 0xF) & ~0xF)
+
+// Assigns tree offsets in document order, returns the tree size
+size_t rco_writer_layout(RcoWriter *pWriter){
+
+	RcoWriterElement *elm = pWriter->root;
+	size_t offset = 0;
+
+	while(elm != NULL){
+		elm->offset = offset;
+		offset += sizeof(SceRcoTreeHeader) + 0x10 * elm->nAttribute;
+
+		if(elm->child != NULL){
+			elm = elm->child;
+			continue;
+		}
+
+		while(elm->next == NULL && elm->parent != NULL){
+			elm = elm->parent;
+		}
+
+		elm = elm->next;
+	}
+
+	return offset;
+}
+
+#define RCO_WRITER_ELM_OFFSET(elm) (((elm) != NULL) ? (elm)->offset : -1)
+
+void rco_writer_write_tree(RcoWriter *pWriter, void *tree){
+
+	RcoWriterElement *elm = pWriter->root;
+
+	while(elm != NULL){
+		SceRcoTreeHeader *header = (SceRcoTreeHeader *)(tree + elm->offset);
+		SceInt32 *attr_data = (SceInt32 *)(header + 1);
+
+		header->name_handle            = elm->name_handle;
+		header->num_attributes         = elm->nAttribute;
+		header->parent_elm_offset      = RCO_WRITER_ELM_OFFSET(elm->parent);
+		header->prev_elm_offset        = RCO_WRITER_ELM_OFFSET(elm->prev);
+		header->next_elm_offset        = RCO_WRITER_ELM_OFFSET(elm->next);
+		header->first_child_elm_offset = RCO_WRITER_ELM_OFFSET(elm->child);
+		header->last_child_elm_offset  = RCO_WRITER_ELM_OFFSET(elm->last_child);
+
+		for(RcoWriterAttribute *attr=elm->attr;attr!=NULL;attr=attr->next){
+			attr_data[0] = attr->name_handle;
+			attr_data[1] = attr->type;
+			attr_data[2] = attr->v1;
+			attr_data[3] = attr->v2;
+			attr_data += 4;
+		}
+
+		if(elm->child != NULL){
+			elm = elm->child;
+			continue;
+		}
+
+		while(elm->next == NULL && elm->parent != NULL){
+			elm = elm->parent;
+		}
+
+		elm = elm->next;
+	}
+}
+
+int rco_writer_finish(RcoWriter *pWriter, const char *magic, void **ppData, size_t *pSize){
+
+	SceRcoHeader *pHeader;
+	size_t tree_size, offset, total;
+	SceInt32 *table_fields[RCO_WRITER_TABLE_MAX];
+	void *data;
+
+	*ppData = NULL;
+	*pSize  = 0;
+
+	tree_size = rco_writer_layout(pWriter);
+
+	// Newest first, so when two elements define the same idhash the first one wins
+	for(RcoWriterFixup *fixup=pWriter->fixups;fixup!=NULL;fixup=fixup->next){
+		SceInt32 elm_offset = fixup->element->offset;
+		memcpy(pWriter->tables[fixup->table].data + fixup->offset, &elm_offset, sizeof(elm_offset));
+	}
+
+	total = RCO_WRITER_ALIGN(sizeof(SceRcoHeader)) + RCO_WRITER_ALIGN(tree_size);
+	for(int i=0;i<RCO_WRITER_TABLE_MAX;i++){
+		total += RCO_WRITER_ALIGN(pWriter->tables[i].size);
+	}
+
+	data = malloc(total);
+	if(data == NULL){
+		return -1;
+	}
+
+	memset(data, 0, total);
+
+	pHeader = (SceRcoHeader *)data;
+	memcpy(pHeader->magic, magic, 4);
+	pHeader->version = 0x110;
+
+	offset = RCO_WRITER_ALIGN(sizeof(SceRcoHeader));
+
+	pHeader->tree_offset = offset;
+	pHeader->tree_size   = tree_size;
+	rco_writer_write_tree(pWriter, data + offset);
+	offset += RCO_WRITER_ALIGN(tree_size);
+
+	// Same order as the fields of SceRcoHeader
+	table_fields[RCO_WRITER_TABLE_ID]         = &(pHeader->idtable_offset);
+	table_fields[RCO_WRITER_TABLE_IDHASH]     = &(pHeader->idhashtable_offset);
+	table_fields[RCO_WRITER_TABLE_STRING]     = &(pHeader->stringtable_offset);
+	table_fields[RCO_WRITER_TABLE_WSTRING]    = &(pHeader->wstringtable_offset);
+	table_fields[RCO_WRITER_TABLE_HASH]       = &(pHeader->hashtable_offset);
+	table_fields[RCO_WRITER_TABLE_INTARRAY]   = &(pHeader->intarraytable_offset);
+	table_fields[RCO_WRITER_TABLE_FLOATARRAY] = &(pHeader->floatarraytable_offset);
+	table_fields[RCO_WRITER_TABLE_FILE]       = &(pHeader->filetable_offset);
+
+	for(int i=0;i<RCO_WRITER_TABLE_MAX;i++){
+		RcoWriterTable *table = &(pWriter->tables[i]);
+
+		table_fields[i][0] = offset;
+		table_fields[i][1] = table->size;
+
+		if(table->size != 0){
+			memcpy(data + offset, table->data, table->size);
+		}
+
+		offset += RCO_WRITER_ALIGN(table->size);
+	}
+
+	*ppData = data;
+	*pSize  = total;
+
+	return 0;
+}
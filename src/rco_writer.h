@@ -0,0 +1,53 @@
+
+#ifndef _RCO_WRITER_H_
+#define _RCO_WRITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef struct RcoWriter RcoWriter;
+typedef struct RcoWriterElement RcoWriterElement;
+
+/*
+ * Builds a CXML tree in memory and lays it out as an RCOF/RCSF image.
+ * Element and attribute names share the stringtable and are stored once.
+ * Payloads are stored as given, compressing them is up to the caller.
+ */
+int rco_writer_create(RcoWriter **ppWriter);
+int rco_writer_destroy(RcoWriter *pWriter);
+
+// parent == NULL adds a root level element
+RcoWriterElement *rco_writer_add_element(RcoWriter *pWriter, RcoWriterElement *parent, const char *name);
+RcoWriterElement *rco_writer_element_get_parent(const RcoWriterElement *elm);
+
+int rco_writer_add_int(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, int32_t value);
+int rco_writer_add_float(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, float value);
+int rco_writer_add_string(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const char *str);
+int rco_writer_add_wstring(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const uint16_t *wstr, int len);
+int rco_writer_add_hash(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value);
+int rco_writer_add_intarray(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const int32_t *data, int count);
+int rco_writer_add_floatarray(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const float *data, int count);
+int rco_writer_add_file(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const void *data, int size);
+int rco_writer_add_id(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, const char *id);
+int rco_writer_add_idref(RcoWriter *pWriter, RcoWriterElement *elm, const char *key);
+int rco_writer_add_idhash(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value);
+int rco_writer_add_idhashref(RcoWriter *pWriter, RcoWriterElement *elm, const char *key, uint32_t value);
+
+/*
+ * magic is "RCOF" or "RCSF". *ppData is allocated with malloc and owned by
+ * the caller.
+ */
+int rco_writer_finish(RcoWriter *pWriter, const char *magic, void **ppData, size_t *pSize);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RCO_WRITER_H_ */
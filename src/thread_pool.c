@@ -0,0 +1,238 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+
+typedef struct ThreadPoolJob {
+	struct ThreadPoolJob *next;
+	ThreadPoolEntry entry;
+	void *argp;
+} ThreadPoolJob;
+
+typedef struct ThreadPoolWorker {
+	struct ThreadPool *pPool;
+	int index;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+	pthread_mutex_t lock;
+	pthread_cond_t job_cond;
+	pthread_cond_t idle_cond;
+	ThreadPoolJob *head;
+	ThreadPoolJob *tail;
+	int nPending; // queued + running
+	int result;
+	int is_exit;
+	int nThread;
+	pthread_t *threads;
+	ThreadPoolWorker *workers;
+};
+
+static __thread int thread_pool_worker_index = 0;
+
+int thread_pool_get_cpu_count(void){
+
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if(n < 1){
+		return 1;
+	}
+
+	return (int)n;
+}
+
+int thread_pool_get_thread_count(ThreadPool *pPool){
+
+	if(pPool == NULL){
+		return 1;
+	}
+
+	return pPool->nThread;
+}
+
+int thread_pool_get_worker_index(void){
+	return thread_pool_worker_index;
+}
+
+static void *thread_pool_worker(void *argp){
+
+	int res;
+	ThreadPoolWorker *worker = (ThreadPoolWorker *)argp;
+	ThreadPool *pPool = worker->pPool;
+	ThreadPoolJob *job;
+
+	thread_pool_worker_index = worker->index;
+
+	pthread_mutex_lock(&pPool->lock);
+
+	while(1){
+		while(pPool->head == NULL && pPool->is_exit == 0){
+			pthread_cond_wait(&pPool->job_cond, &pPool->lock);
+		}
+
+		if(pPool->head == NULL){ // is_exit
+			break;
+		}
+
+		job = pPool->head;
+		pPool->head = job->next;
+		if(pPool->head == NULL){
+			pPool->tail = NULL;
+		}
+
+		pthread_mutex_unlock(&pPool->lock);
+
+		res = job->entry(job->argp);
+		free(job);
+
+		pthread_mutex_lock(&pPool->lock);
+
+		if(res < 0 && pPool->result >= 0){
+			pPool->result = res;
+		}
+
+		pPool->nPending -= 1;
+		if(pPool->nPending == 0){
+			pthread_cond_broadcast(&pPool->idle_cond);
+		}
+	}
+
+	pthread_mutex_unlock(&pPool->lock);
+
+	return NULL;
+}
+
+int thread_pool_create(ThreadPool **ppPool, int nThread){
+
+	ThreadPool *pPool;
+
+	if(nThread < 1){
+		nThread = thread_pool_get_cpu_count();
+	}
+
+	pPool = malloc(sizeof(*pPool));
+	if(pPool == NULL){
+		return -1;
+	}
+
+	memset(pPool, 0, sizeof(*pPool));
+
+	pPool->threads = malloc(sizeof(pthread_t) * nThread);
+	pPool->workers = malloc(sizeof(ThreadPoolWorker) * nThread);
+	if(pPool->threads == NULL || pPool->workers == NULL){
+		free(pPool->threads);
+		free(pPool->workers);
+		free(pPool);
+		return -1;
+	}
+
+	pthread_mutex_init(&pPool->lock, NULL);
+	pthread_cond_init(&pPool->job_cond, NULL);
+	pthread_cond_init(&pPool->idle_cond, NULL);
+
+	for(int i=0;i<nThread;i++){
+		pPool->workers[i].pPool = pPool;
+		pPool->workers[i].index = i;
+
+		if(pthread_create(&pPool->threads[i], NULL, thread_pool_worker, &pPool->workers[i]) != 0){
+			printf("%s: cannot create worker %d\n", __FUNCTION__, i);
+			break;
+		}
+
+		pPool->nThread += 1;
+	}
+
+	if(pPool->nThread == 0){
+		thread_pool_destroy(pPool);
+		return -1;
+	}
+
+	*ppPool = pPool;
+
+	return 0;
+}
+
+int thread_pool_destroy(ThreadPool *pPool){
+
+	if(pPool == NULL){
+		return 0;
+	}
+
+	pthread_mutex_lock(&pPool->lock);
+	pPool->is_exit = 1;
+	pthread_cond_broadcast(&pPool->job_cond);
+	pthread_mutex_unlock(&pPool->lock);
+
+	for(int i=0;i<pPool->nThread;i++){
+		pthread_join(pPool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pPool->idle_cond);
+	pthread_cond_destroy(&pPool->job_cond);
+	pthread_mutex_destroy(&pPool->lock);
+
+	free(pPool->threads);
+	free(pPool->workers);
+	free(pPool);
+
+	return 0;
+}
+
+int thread_pool_submit(ThreadPool *pPool, ThreadPoolEntry entry, void *argp){
+
+	ThreadPoolJob *job;
+
+	if(pPool == NULL){
+		return entry(argp);
+	}
+
+	job = malloc(sizeof(*job));
+	if(job == NULL){
+		return -1;
+	}
+
+	job->next  = NULL;
+	job->entry = entry;
+	job->argp  = argp;
+
+	pthread_mutex_lock(&pPool->lock);
+
+	if(pPool->tail != NULL){
+		pPool->tail->next = job;
+	}else{
+		pPool->head = job;
+	}
+
+	pPool->tail = job;
+	pPool->nPending += 1;
+
+	pthread_cond_signal(&pPool->job_cond);
+	pthread_mutex_unlock(&pPool->lock);
+
+	return 0;
+}
+
+int thread_pool_wait(ThreadPool *pPool){
+
+	int res;
+
+	if(pPool == NULL){
+		return 0;
+	}
+
+	pthread_mutex_lock(&pPool->lock);
+
+	while(pPool->nPending != 0){
+		pthread_cond_wait(&pPool->idle_cond, &pPool->lock);
+	}
+
+	res = pPool->result;
+	pPool->result = 0;
+
+	pthread_mutex_unlock(&pPool->lock);
+
+	return res;
+}
@@ -0,0 +1,39 @@
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct ThreadPool ThreadPool;
+
+typedef int (* ThreadPoolEntry)(void *argp);
+
+int thread_pool_get_cpu_count(void);
+
+int thread_pool_create(ThreadPool **ppPool, int nThread);
+int thread_pool_destroy(ThreadPool *pPool);
+
+/*
+ * Workers are numbered from 0 to thread_pool_get_thread_count() - 1.
+ * Outside of a worker (or for a NULL pool) the index and count are 0 and 1.
+ */
+int thread_pool_get_thread_count(ThreadPool *pPool);
+int thread_pool_get_worker_index(void);
+
+/*
+ * Jobs are run in submission order. A job returning a negative value is
+ * remembered and reported by the next thread_pool_wait.
+ * If pPool is NULL the job is run inline and its result is returned.
+ */
+int thread_pool_submit(ThreadPool *pPool, ThreadPoolEntry entry, void *argp);
+int thread_pool_wait(ThreadPool *pPool);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREAD_POOL_H_ */
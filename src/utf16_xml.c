@@ -0,0 +1,282 @@
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "utf16_xml.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+#define UTF16_XML_CHUNK (0x400)
+
+// "&quot;" is the longest output of a single code unit
+#define UTF16_XML_MAX_PER_UNIT (6)
+
+static char *utf16_xml_escape(char *p, uint16_t c){
+
+	switch(c){
+	case '&':
+		memcpy(p, "&amp;", 5);
+		return p + 5;
+	case '<':
+		memcpy(p, "&lt;", 4);
+		return p + 4;
+	case '>':
+		memcpy(p, "&gt;", 4);
+		return p + 4;
+	case '"':
+		memcpy(p, "&quot;", 6);
+		return p + 6;
+	case '\n':
+		memcpy(p, "&#xA;", 5);
+		return p + 5;
+	default:
+		*p = (char)c;
+		return p + 1;
+	}
+}
+
+// "\u001F" is the longest JSON escape, as long as "&quot;"
+static char *utf16_json_escape(char *p, uint16_t c){
+
+	switch(c){
+	case '"':
+		memcpy(p, "\\\"", 2);
+		return p + 2;
+	case '\\':
+		memcpy(p, "\\\\", 2);
+		return p + 2;
+	case '\n':
+		memcpy(p, "\\n", 2);
+		return p + 2;
+	case '\r':
+		memcpy(p, "\\r", 2);
+		return p + 2;
+	case '\t':
+		memcpy(p, "\\t", 2);
+		return p + 2;
+	default:
+		if(c < 0x20){
+			memcpy(p, "\\u00", 4);
+			p[4] = "0123456789ABCDEF"[c >> 4];
+			p[5] = "0123456789ABCDEF"[c & 0xF];
+			return p + 6;
+		}
+
+		*p = (char)c;
+		return p + 1;
+	}
+}
+
+/*
+ * Converts up to n code units and returns how many were consumed. A high
+ * surrogate at the end of the chunk is left for the next call when more
+ * input follows.
+ */
+static size_t utf16_xml_chunk(char **pp, const uint16_t *src, size_t n, int is_last, int is_json){
+
+	char *p = *pp;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128i ascii_mask = _mm_set1_epi16((short)0xFF80);
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i amp   = _mm_set1_epi16('&');
+	const __m128i lt    = _mm_set1_epi16('<');
+	const __m128i gt    = _mm_set1_epi16('>');
+	const __m128i quot  = _mm_set1_epi16('"');
+	const __m128i lf    = _mm_set1_epi16('\n');
+	const __m128i bslash = _mm_set1_epi16('\\');
+	const __m128i space = _mm_set1_epi16(' ');
+#endif
+
+	while(i < n){
+
+#if defined(__SSE2__)
+		// Plain ASCII runs are narrowed 8 code units at a time
+		while((i + 8) <= n){
+			__m128i v = _mm_loadu_si128((const __m128i *)&(src[i]));
+			__m128i is_ascii = _mm_cmpeq_epi16(_mm_and_si128(v, ascii_mask), zero);
+			__m128i is_special;
+
+			if(is_json == 0){
+				is_special = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi16(v, amp), _mm_cmpeq_epi16(v, lt)),
+					_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, gt), _mm_cmpeq_epi16(v, quot)), _mm_cmpeq_epi16(v, lf))
+				);
+			}else{
+				// Units from 0x8000 compare as negative, but they are not ASCII anyway
+				is_special = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi16(v, quot), _mm_cmpeq_epi16(v, bslash)),
+					_mm_cmplt_epi16(v, space)
+				);
+			}
+
+			int mask = _mm_movemask_epi8(_mm_andnot_si128(is_special, is_ascii)) ^ 0xFFFF;
+
+			_mm_storel_epi64((__m128i *)p, _mm_packus_epi16(v, v));
+
+			if(mask == 0){
+				p += 8;
+				i += 8;
+				continue;
+			}
+
+			// Keep the plain prefix and let the scalar path take the rest
+			int nPlain = __builtin_ctz(mask) >> 1;
+			p += nPlain;
+			i += nPlain;
+			break;
+		}
+
+		if(i >= n){
+			break;
+		}
+#endif
+
+		uint16_t c = src[i];
+
+		if(c < 0x80){
+			p = (is_json != 0) ? utf16_json_escape(p, c) : utf16_xml_escape(p, c);
+			i += 1;
+		}else if(c < 0x800){
+			p[0] = 0xC0 | (c >> 6);
+			p[1] = 0x80 | (c & 0x3F);
+			p += 2;
+			i += 1;
+		}else if(c >= 0xD800 && c <= 0xDBFF){
+			if((i + 1) >= n && is_last == 0){
+				break;
+			}
+
+			uint16_t c2 = ((i + 1) < n) ? src[i + 1] : 0;
+
+			if(c2 >= 0xDC00 && c2 <= 0xDFFF){
+				uint32_t cp = 0x10000 + (((uint32_t)(c - 0xD800) << 10) | (c2 - 0xDC00));
+
+				p[0] = 0xF0 | (cp >> 18);
+				p[1] = 0x80 | ((cp >> 12) & 0x3F);
+				p[2] = 0x80 | ((cp >> 6) & 0x3F);
+				p[3] = 0x80 | (cp & 0x3F);
+				p += 4;
+				i += 2;
+			}else{
+				memcpy(p, "\xEF\xBF\xBD", 3);
+				p += 3;
+				i += 1;
+			}
+		}else if(c >= 0xDC00 && c <= 0xDFFF){
+			memcpy(p, "\xEF\xBF\xBD", 3);
+			p += 3;
+			i += 1;
+		}else{
+			p[0] = 0xE0 | (c >> 12);
+			p[1] = 0x80 | ((c >> 6) & 0x3F);
+			p[2] = 0x80 | (c & 0x3F);
+			p += 3;
+			i += 1;
+		}
+	}
+
+	*pp = p;
+
+	return i;
+}
+
+static int utf16_print(OutBuffer *out, const uint16_t *wstr, size_t len, int is_json){
+
+	while(len != 0){
+		size_t n = (len > UTF16_XML_CHUNK) ? UTF16_XML_CHUNK : len;
+
+		// SIMD stores may run up to 8 bytes past the last converted unit
+		char *start = out_buffer_reserve(out, n * UTF16_XML_MAX_PER_UNIT + 8);
+		if(start == NULL){
+			return -1;
+		}
+
+		char *p = start;
+		size_t done = utf16_xml_chunk(&p, wstr, n, n == len, is_json);
+
+		out->pos += p - start;
+
+		wstr += done;
+		len  -= done;
+	}
+
+	return 0;
+}
+
+int utf16_print_xml(OutBuffer *out, const uint16_t *wstr, size_t len){
+	return utf16_print(out, wstr, len, 0);
+}
+
+int utf16_print_json(OutBuffer *out, const uint16_t *wstr, size_t len){
+	return utf16_print(out, wstr, len, 1);
+}
+
+size_t utf8_to_utf16(uint16_t *dst, const char *src, size_t len){
+
+	const unsigned char *s = (const unsigned char *)src;
+	size_t i = 0, n = 0;
+
+	while(i < len){
+		uint32_t c = s[i];
+		size_t extra;
+
+		if(c < 0x80){
+			dst[n++] = c;
+			i++;
+			continue;
+		}
+
+		if((c & 0xE0) == 0xC0){
+			extra = 1;
+			c &= 0x1F;
+		}else if((c & 0xF0) == 0xE0){
+			extra = 2;
+			c &= 0x0F;
+		}else if((c & 0xF8) == 0xF0){
+			extra = 3;
+			c &= 0x07;
+		}else{
+			dst[n++] = 0xFFFD;
+			i++;
+			continue;
+		}
+
+		if(i + extra >= len){
+			dst[n++] = 0xFFFD;
+			break;
+		}
+
+		size_t k;
+		for(k=1;k<=extra;k++){
+			if((s[i + k] & 0xC0) != 0x80){
+				break;
+			}
+
+			c = (c << 6) | (s[i + k] & 0x3F);
+		}
+
+		if(k <= extra){
+			dst[n++] = 0xFFFD;
+			i += k;
+			continue;
+		}
+
+		i += 1 + extra;
+
+		if(c >= 0x10000){
+			// 4 bytes in, 2 units out, so dst stays within len units
+			c -= 0x10000;
+			dst[n++] = 0xD800 | (c >> 10);
+			dst[n++] = 0xDC00 | (c & 0x3FF);
+		}else{
+			dst[n++] = c;
+		}
+	}
+
+	return n;
+}
@@ -0,0 +1,37 @@
+
+#ifndef _UTF16_XML_H_
+#define _UTF16_XML_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "out_buffer.h"
+
+
+/*
+ * Writes len UTF-16LE code units as UTF-8 with &, <, >, " and newline
+ * escaped for use inside an XML attribute value. Surrogate pairs become
+ * one 4-byte sequence, unpaired surrogates become U+FFFD.
+ */
+int utf16_print_xml(OutBuffer *out, const uint16_t *wstr, size_t len);
+
+// The same for the inside of a JSON string: ", \ and control characters are escaped
+int utf16_print_json(OutBuffer *out, const uint16_t *wstr, size_t len);
+
+/*
+ * The other way, for the compiler: converts len bytes of UTF-8 to UTF-16LE.
+ * dst needs room for len units. Malformed sequences become U+FFFD.
+ * Returns the number of units written.
+ */
+size_t utf8_to_utf16(uint16_t *dst, const char *src, size_t len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UTF16_XML_H_ */
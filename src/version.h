@@ -0,0 +1,7 @@
+
+#ifndef _VERSION_H_
+#define _VERSION_H_
+
+#define RCO_DECOMPILER_VERSION "1.1.0"
+
+#endif /* _VERSION_H_ */
@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+#include "xml_reader.h"
+
+
+typedef struct XmlReader {
+	Arena *arena;
+	const char *p;
+	const char *end;
+	int line;
+} XmlReader;
+
+static int xml_is_space(char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int xml_is_name_char(char c){
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':' || c == '-' || c == '.' || (unsigned char)c >= 0x80;
+}
+
+static void xml_skip_space(XmlReader *reader){
+
+	while(reader->p < reader->end && xml_is_space(*reader->p)){
+		if(*reader->p == '\n'){
+			reader->line++;
+		}
+
+		reader->p++;
+	}
+}
+
+// Moves past the next occurrence of str, returns -1 if there is none
+static int xml_skip_past(XmlReader *reader, const char *str){
+
+	size_t len = strlen(str);
+
+	while((size_t)(reader->end - reader->p) >= len){
+		if(memcmp(reader->p, str, len) == 0){
+			reader->p += len;
+			return 0;
+		}
+
+		if(*reader->p == '\n'){
+			reader->line++;
+		}
+
+		reader->p++;
+	}
+
+	return -1;
+}
+
+static int xml_starts_with(const XmlReader *reader, const char *str){
+
+	size_t len = strlen(str);
+
+	return (size_t)(reader->end - reader->p) >= len && memcmp(reader->p, str, len) == 0;
+}
+
+static const char *xml_parse_name(XmlReader *reader){
+
+	const char *start = reader->p;
+
+	while(reader->p < reader->end && xml_is_name_char(*reader->p)){
+		reader->p++;
+	}
+
+	if(reader->p == start){
+		return NULL;
+	}
+
+	return arena_strndup(reader->arena, start, reader->p - start);
+}
+
+static size_t xml_put_utf8(char *dst, uint32_t c){
+
+	if(c < 0x80){
+		dst[0] = c;
+		return 1;
+	}
+
+	if(c < 0x800){
+		dst[0] = 0xC0 | (c >> 6);
+		dst[1] = 0x80 | (c & 0x3F);
+		return 2;
+	}
+
+	if(c < 0x10000){
+		dst[0] = 0xE0 | (c >> 12);
+		dst[1] = 0x80 | ((c >> 6) & 0x3F);
+		dst[2] = 0x80 | (c & 0x3F);
+		return 3;
+	}
+
+	dst[0] = 0xF0 | (c >> 18);
+	dst[1] = 0x80 | ((c >> 12) & 0x3F);
+	dst[2] = 0x80 | ((c >> 6) & 0x3F);
+	dst[3] = 0x80 | (c & 0x3F);
+	return 4;
+}
+
+// Decodes one entity at src (just after '&'), returns its length up to ';' or 0
+static size_t xml_decode_entity(const char *src, const char *end, char *dst, size_t *pOut){
+
+	const char *semicolon = memchr(src, ';', end - src);
+	size_t len;
+
+	if(semicolon == NULL){
+		return 0;
+	}
+
+	len = semicolon - src;
+
+	if(len == 3 && memcmp(src, "amp", 3) == 0){
+		*dst = '&';
+	}else if(len == 2 && memcmp(src, "lt", 2) == 0){
+		*dst = '<';
+	}else if(len == 2 && memcmp(src, "gt", 2) == 0){
+		*dst = '>';
+	}else if(len == 4 && memcmp(src, "quot", 4) == 0){
+		*dst = '"';
+	}else if(len == 4 && memcmp(src, "apos", 4) == 0){
+		*dst = '\'';
+	}else if(len >= 2 && src[0] == '#'){
+		char number[0x10];
+		uint32_t c;
+
+		if(len >= sizeof(number)){
+			return 0;
+		}
+
+		memcpy(number, src + 1, len - 1);
+		number[len - 1] = 0;
+
+		if(number[0] == 'x' || number[0] == 'X'){
+			c = strtoul(&(number[1]), NULL, 16);
+		}else{
+			c = strtoul(number, NULL, 10);
+		}
+
+		if(c > 0x10FFFF){
+			return 0;
+		}
+
+		*pOut = xml_put_utf8(dst, c);
+		return len + 1;
+	}else{
+		return 0;
+	}
+
+	*pOut = 1;
+
+	return len + 1;
+}
+
+static int xml_parse_value(XmlReader *reader, XmlAttribute *attr){
+
+	char quote;
+	const char *start, *p;
+	char *value;
+	size_t len = 0;
+
+	if(reader->p >= reader->end || (*reader->p != '"' && *reader->p != '\'')){
+		return -1;
+	}
+
+	quote = *reader->p++;
+	start = reader->p;
+
+	p = memchr(start, quote, reader->end - start);
+	if(p == NULL){
+		return -1;
+	}
+
+	// Decoding never makes it longer, &#x10000; and up included
+	value = arena_alloc(reader->arena, (p - start) + 1);
+	if(value == NULL){
+		return -1;
+	}
+
+	while(reader->p < p){
+		char c = *reader->p;
+
+		if(c == '&'){
+			size_t out = 0;
+			size_t consumed = xml_decode_entity(reader->p + 1, p, &(value[len]), &out);
+			if(consumed == 0){
+				return -1;
+			}
+
+			reader->p += 1 + consumed;
+			len += out;
+			continue;
+		}
+
+		if(c == '\n'){
+			reader->line++;
+		}
+
+		value[len++] = c;
+		reader->p++;
+	}
+
+	value[len] = 0;
+	reader->p++;
+
+	attr->value     = value;
+	attr->value_len = len;
+
+	return 0;
+}
+
+static int xml_parse_element(XmlReader *reader, XmlNode *node, int *pIsEmpty){
+
+	XmlAttribute **tail = &(node->attr);
+
+	node->name = xml_parse_name(reader);
+	if(node->name == NULL){
+		return -1;
+	}
+
+	while(1){
+		xml_skip_space(reader);
+
+		if(reader->p >= reader->end){
+			return -1;
+		}
+
+		if(*reader->p == '>'){
+			reader->p++;
+			*pIsEmpty = 0;
+			return 0;
+		}
+
+		if(xml_starts_with(reader, "/>")){
+			reader->p += 2;
+			*pIsEmpty = 1;
+			return 0;
+		}
+
+		XmlAttribute *attr = arena_alloc(reader->arena, sizeof(*attr));
+		if(attr == NULL){
+			return -1;
+		}
+
+		memset(attr, 0, sizeof(*attr));
+
+		attr->name = xml_parse_name(reader);
+		if(attr->name == NULL){
+			return -1;
+		}
+
+		xml_skip_space(reader);
+		if(reader->p >= reader->end || *reader->p != '='){
+			return -1;
+		}
+
+		reader->p++;
+		xml_skip_space(reader);
+
+		if(xml_parse_value(reader, attr) < 0){
+			return -1;
+		}
+
+		*tail = attr;
+		tail = &(attr->next);
+	}
+}
+
+int xml_reader_parse(Arena *arena, const char *data, size_t size, XmlNode **ppRoot){
+
+	XmlReader reader;
+	XmlNode *root = NULL, *current = NULL;
+	const char *error = NULL;
+
+	reader.arena = arena;
+	reader.p     = data;
+	reader.end   = data + size;
+	reader.line  = 1;
+
+	*ppRoot = NULL;
+
+	while(reader.p < reader.end && error == NULL){
+
+		if(*reader.p != '<'){
+			// Text content is not part of CXML
+			if(*reader.p == '\n'){
+				reader.line++;
+			}
+
+			reader.p++;
+			continue;
+		}
+
+		if(xml_starts_with(&reader, "<?")){
+			if(xml_skip_past(&reader, "?>") < 0){
+				error = "unterminated processing instruction";
+			}
+		}else if(xml_starts_with(&reader, "<!--")){
+			if(xml_skip_past(&reader, "-->") < 0){
+				error = "unterminated comment";
+			}
+		}else if(xml_starts_with(&reader, "<!")){
+			if(xml_skip_past(&reader, ">") < 0){
+				error = "unterminated declaration";
+			}
+		}else if(xml_starts_with(&reader, "</")){
+			reader.p += 2;
+
+			const char *start = reader.p;
+			while(reader.p < reader.end && xml_is_name_char(*reader.p)){
+				reader.p++;
+			}
+
+			if(current == NULL || strlen(current->name) != (size_t)(reader.p - start) || memcmp(current->name, start, reader.p - start) != 0){
+				error = "mismatched end tag";
+				break;
+			}
+
+			xml_skip_space(&reader);
+			if(reader.p >= reader.end || *reader.p != '>'){
+				error = "bad end tag";
+				break;
+			}
+
+			reader.p++;
+			current = current->parent;
+		}else{
+			int is_empty;
+			XmlNode *node = arena_alloc(arena, sizeof(*node));
+			if(node == NULL){
+				error = "out of memory";
+				break;
+			}
+
+			memset(node, 0, sizeof(*node));
+			node->line   = reader.line;
+			node->parent = current;
+
+			reader.p++;
+
+			if(xml_parse_element(&reader, node, &is_empty) < 0){
+				error = "bad element";
+				break;
+			}
+
+			if(current != NULL){
+				if(current->last_child != NULL){
+					current->last_child->next = node;
+				}else{
+					current->child = node;
+				}
+
+				current->last_child = node;
+			}else if(root == NULL){
+				root = node;
+			}else{
+				error = "more than one root element";
+				break;
+			}
+
+			if(is_empty == 0){
+				current = node;
+			}
+		}
+	}
+
+	if(error == NULL && current != NULL){
+		error = "unclosed element";
+	}
+
+	if(error == NULL && root == NULL){
+		error = "no root element";
+	}
+
+	if(error != NULL){
+		printf("xml: line %d: %s\n", reader.line, error);
+		return -1;
+	}
+
+	*ppRoot = root;
+
+	return 0;
+}
+
+const XmlAttribute *xml_node_get_attribute(const XmlNode *node, const char *name){
+
+	const XmlAttribute *attr = node->attr;
+
+	while(attr != NULL){
+		if(strcmp(attr->name, name) == 0){
+			return attr;
+		}
+
+		attr = attr->next;
+	}
+
+	return NULL;
+}
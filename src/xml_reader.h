@@ -0,0 +1,45 @@
+
+#ifndef _XML_READER_H_
+#define _XML_READER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include "arena.h"
+
+
+typedef struct XmlAttribute {
+	struct XmlAttribute *next;
+	const char *name;
+	const char *value; // entities decoded, NUL terminated
+	size_t value_len;
+} XmlAttribute;
+
+typedef struct XmlNode {
+	struct XmlNode *parent;
+	struct XmlNode *child;
+	struct XmlNode *last_child;
+	struct XmlNode *next;
+	const char *name;
+	XmlAttribute *attr;
+	int line;
+} XmlNode;
+
+/*
+ * Parses the subset of XML the decompiler writes: elements and attributes.
+ * Text content, comments, processing instructions and DOCTYPE are skipped.
+ * Everything is allocated from arena.
+ */
+int xml_reader_parse(Arena *arena, const char *data, size_t size, XmlNode **ppRoot);
+
+const XmlAttribute *xml_node_get_attribute(const XmlNode *node, const char *name);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XML_READER_H_ */
@@ -0,0 +1,54 @@
+# Nightly re-runs go into an output directory that already exists. A changed
+# input must still be stored, without the files of earlier runs, so the next
+# run of it is a cache hit.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DWORK_DIR=<dir> -P cache_rerun.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+# Fails unless the last line of the stats file says whether it was cached
+function(check_cached expected)
+  file(STRINGS ${WORK_DIR}/stats.jsonl lines)
+  list(GET lines -1 line)
+  if(NOT line MATCHES "\"cached\":${expected}")
+    message(FATAL_ERROR "expected \"cached\":${expected}, got ${line}")
+  endif()
+endfunction()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/out)
+
+make_input(first first_a first_b first_c first_d)
+make_input(second second_a second_b second_c second_d)
+
+# The output directory exists before the cache is first used
+run_checked(${WORK_DIR}/out ../first/plugin.rco)
+file(WRITE ${WORK_DIR}/out/plugin/stale.txt "stale")
+
+run_checked(${WORK_DIR}/out --cache ../cache --stats ../stats.jsonl ../first/plugin.rco)
+check_cached(false)
+
+# The input changed, into the same directory
+run_checked(${WORK_DIR}/out --cache ../cache --stats ../stats.jsonl ../second/plugin.rco)
+check_cached(false)
+check_textures(${WORK_DIR}/out second_a second_b second_c second_d)
+
+run_checked(${WORK_DIR}/out --cache ../cache --stats ../stats.jsonl ../second/plugin.rco)
+check_cached(true)
+check_textures(${WORK_DIR}/out second_a second_b second_c second_d)
+
+run_checked(${WORK_DIR}/out --cache ../cache --stats ../stats.jsonl ../first/plugin.rco)
+check_cached(true)
+check_textures(${WORK_DIR}/out first_a first_b first_c first_d)
+
+# Neither entry picked up the file of the earlier run, and no temporary directory is left
+file(MAKE_DIRECTORY ${WORK_DIR}/fresh)
+run_checked(${WORK_DIR}/fresh --cache ../cache ../second/plugin.rco)
+if(EXISTS ${WORK_DIR}/fresh/plugin/stale.txt)
+  message(FATAL_ERROR "the cache entry holds stale.txt")
+endif()
+
+file(GLOB leftovers ${WORK_DIR}/out/plugin.tmp.* ${WORK_DIR}/fresh/plugin.tmp.*)
+if(leftovers)
+  message(FATAL_ERROR "temporary directories left: ${leftovers}")
+endif()
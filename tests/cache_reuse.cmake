@@ -0,0 +1,31 @@
+# A cache hit links the cached files into the output directory. A later run
+# without the cache into that directory must not change the cached entry.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DWORK_DIR=<dir> -P cache_reuse.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/out)
+
+make_input(first first_a first_b first_c first_d)
+make_input(second second_a second_b second_c second_d)
+
+# Stores the entry, then links it back into a fresh output directory
+run_checked(${WORK_DIR}/out --cache ../cache ../first/plugin.rco)
+file(READ ${WORK_DIR}/out/plugin/plugin.xml first_xml)
+file(REMOVE_RECURSE ${WORK_DIR}/out/plugin)
+run_checked(${WORK_DIR}/out --cache ../cache ../first/plugin.rco)
+
+run_checked(${WORK_DIR}/out ../second/plugin.rco)
+check_textures(${WORK_DIR}/out second_a second_b second_c second_d)
+
+file(REMOVE_RECURSE ${WORK_DIR}/out/plugin)
+run_checked(${WORK_DIR}/out --cache ../cache ../first/plugin.rco)
+check_textures(${WORK_DIR}/out first_a first_b first_c first_d)
+
+# The sizes differ, so the XML of the second input differs in origsize
+file(READ ${WORK_DIR}/out/plugin/plugin.xml xml)
+if(NOT xml STREQUAL first_xml)
+  message(FATAL_ERROR "cached plugin.xml changed:\n${xml}")
+endif()
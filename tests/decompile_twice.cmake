@@ -0,0 +1,18 @@
+# Decompiles two inputs with the same name into one output directory. The
+# first has identical textures, which end up hardlinked to each other; the
+# second has different ones, which must not be written through that link.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DWORK_DIR=<dir> -P decompile_twice.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/out)
+
+make_input(first same same twin twin)
+make_input(second first_png second_png first_gim second_gim)
+
+run_checked(${WORK_DIR}/out ../first/plugin.rco)
+run_checked(${WORK_DIR}/out ../second/plugin.rco)
+
+check_textures(${WORK_DIR}/out first_png second_png first_gim second_gim)
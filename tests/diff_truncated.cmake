@@ -0,0 +1,42 @@
+# Compares a plugin with truncated copies of itself, which --diff has to
+# refuse with exit code 2 instead of reading past the end of the file.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DWORK_DIR=<dir> -P diff_truncated.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+
+# Large enough payloads that every cut below falls inside the file
+string(REPEAT "stored " 500 stored)
+string(REPEAT "packed " 500 packed)
+make_input(input "${stored}" "${stored}b" "${packed}" "${packed}d")
+
+set(input ${WORK_DIR}/input/plugin.rco)
+
+run_checked(${WORK_DIR} --diff ${input} ${input})
+
+file(SIZE ${input} input_size)
+
+foreach(size 100 1000 5000)
+  if(NOT size LESS input_size)
+    message(FATAL_ERROR "plugin.rco is only ${input_size} bytes")
+  endif()
+
+  execute_process(COMMAND head -c ${size} ${input}
+    OUTPUT_FILE ${WORK_DIR}/cut_${size}.rco
+    RESULT_VARIABLE res)
+  if(NOT res EQUAL 0)
+    message(FATAL_ERROR "cannot truncate plugin.rco")
+  endif()
+
+  foreach(args "${input};${WORK_DIR}/cut_${size}.rco" "${WORK_DIR}/cut_${size}.rco;${input}")
+    execute_process(COMMAND ${RCO_DECOMPILER} --diff ${args}
+      RESULT_VARIABLE res
+      OUTPUT_VARIABLE out
+      ERROR_VARIABLE out)
+    if(NOT res EQUAL 2)
+      message(FATAL_ERROR "--diff ${args} exited with ${res}, expected 2:\n${out}")
+    endif()
+  endforeach()
+endforeach()
@@ -0,0 +1,30 @@
+# Decompiles a generated RCO, whose floats need up to nine digits, compiles
+# the XML back and expects --diff to find no difference at all.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DRCO_BENCH=<exe> -DWORK_DIR=<dir> -P float_roundtrip.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+execute_process(COMMAND ${RCO_BENCH} --generate gen.rco
+  WORKING_DIRECTORY ${WORK_DIR}
+  RESULT_VARIABLE res
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE out)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "RcoBench --generate failed (${res}):\n${out}")
+endif()
+
+run_checked(${WORK_DIR} --schema gen.rco)
+run_checked(${WORK_DIR} --compile gen/gen.xml re.rco)
+
+execute_process(COMMAND ${RCO_DECOMPILER} --diff gen.rco re.rco
+  WORKING_DIRECTORY ${WORK_DIR}
+  RESULT_VARIABLE res
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE out)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "the compiled XML differs from the original (${res}):\n${out}")
+endif()
@@ -0,0 +1,116 @@
+/*
+ * Walks the file compiled by reader_walk.cmake through rco_reader.hpp, and
+ * checks that every cut of it is refused or walked without reading past the
+ * end. Exits with 0 if everything is as expected.
+ *
+ * rco_reader_test <plugin.rco>
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+#include "rco_reader.hpp"
+
+
+static int nError = 0;
+
+#define CHECK(cond) do { \
+	if(!(cond)){ \
+		std::printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		nError++; \
+	} \
+} while(0)
+
+// Visits every element and attribute, and returns the number of elements
+static int walk(rco::ElementView element, int depth){
+
+	int nElement = 1;
+
+	if(depth > 64){
+		return nElement;
+	}
+
+	for(rco::AttributeView attr : element.attributes()){
+		(void)attr.name();
+		(void)attr.as_string();
+		(void)attr.as_file();
+		(void)attr.as_idhash();
+	}
+
+	for(rco::ElementView child : element.children()){
+		nElement += walk(child, depth + 1);
+	}
+
+	return nElement;
+}
+
+int main(int argc, char *argv[]){
+
+	if(argc != 2){
+		std::printf("usage: %s <plugin.rco>\n", argv[0]);
+		return 1;
+	}
+
+	std::ifstream in(argv[1], std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	rco::RcoFile file(data.data(), data.size());
+
+	CHECK(file);
+	CHECK(!file.is_rcs());
+	CHECK(file.root().name() == "resource");
+
+	rco::ElementView table = file.root().child("texturetable");
+	CHECK(table);
+	CHECK(!table.attribute("texture"));
+
+	// The four textures from make_input in test_util.cmake
+	static const std::string_view contents[] = {"first_png", "second_png", "first_gim", "second_gim"};
+	std::uint32_t id = 0x10000000;
+	int nTexture = 0;
+
+	for(rco::ElementView texture : table.children()){
+		CHECK(texture.name() == "texture");
+		CHECK(texture.parent().offset() == table.offset());
+		CHECK(texture.attribute("id").as_idhash() == id);
+		CHECK(!texture.attribute("id").as_string());
+		CHECK(!texture.attribute("missing"));
+
+		std::optional<std::string_view> type = texture.attribute("type").as_string();
+		std::optional<rco::Span<const std::uint8_t>> payload = texture.attribute("src").as_file();
+
+		CHECK(type && payload);
+
+		if(type && payload){
+			if(nTexture < 2){
+				CHECK(*type == "texture/png");
+				CHECK(std::string_view(reinterpret_cast<const char *>(payload->data()), payload->size()) == contents[nTexture]);
+			}else{
+				CHECK(*type == "texture/gim");
+				CHECK(texture.attribute("compress").as_string() == "on");
+				CHECK(texture.attribute("origsize").as_int() == (std::int32_t)contents[nTexture].size());
+				CHECK(!payload->empty());
+			}
+		}
+
+		id++;
+		nTexture++;
+	}
+
+	CHECK(nTexture == 4);
+	CHECK(walk(file.root(), 0) == 6);
+
+	// A cut file is either refused or walked without leaving the buffer
+	for(std::size_t size = 0; size < data.size(); size++){
+		std::vector<char> cut(data.begin(), data.begin() + size);
+		rco::RcoFile part(cut.data(), cut.size());
+
+		if(part){
+			walk(part.root(), 0);
+		}
+	}
+
+	return (nError == 0) ? 0 : 1;
+}
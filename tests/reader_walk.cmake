@@ -0,0 +1,17 @@
+# Compiles a small plugin and walks it with the C++ views of rco_reader.hpp
+#
+# cmake -DRCO_DECOMPILER=<exe> -DRCO_READER_TEST=<exe> -DWORK_DIR=<dir> -P reader_walk.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+
+make_input(input first_png second_png first_gim second_gim)
+
+execute_process(COMMAND ${RCO_READER_TEST} ${WORK_DIR}/input/plugin.rco
+  RESULT_VARIABLE res
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE out)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "rco_reader_test failed (${res}):\n${out}")
+endif()
@@ -0,0 +1,54 @@
+# With --stats -, stdout must hold one JSON object per input and line and
+# nothing else; the batch status lines go to stderr.
+#
+# cmake -DRCO_DECOMPILER=<exe> -DWORK_DIR=<dir> -P stats_stdout.cmake
+
+cmake_minimum_required(VERSION 3.19) # string(JSON)
+
+include(${CMAKE_CURRENT_LIST_DIR}/test_util.cmake)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/out)
+
+make_input(first first_a first_b first_c first_d)
+make_input(second second_a second_b second_c second_d)
+
+# Different names, so the batch writes them to different directories
+file(RENAME ${WORK_DIR}/first/plugin.rco ${WORK_DIR}/first/a.rco)
+file(RENAME ${WORK_DIR}/second/plugin.rco ${WORK_DIR}/second/b.rco)
+
+execute_process(COMMAND ${RCO_DECOMPILER} --stats - ../first/a.rco ../second/b.rco
+  WORKING_DIRECTORY ${WORK_DIR}/out
+  RESULT_VARIABLE res
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE err)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "RcoDecompiler --stats - failed (${res}):\n${out}${err}")
+endif()
+
+if(NOT err MATCHES "\\[ OK \\] \\.\\./first/a\\.rco" OR NOT err MATCHES "\\[ OK \\] \\.\\./second/b\\.rco")
+  message(FATAL_ERROR "status lines are not on stderr:\n${err}")
+endif()
+
+string(REGEX REPLACE "\n$" "" out "${out}")
+string(REPLACE "\n" ";" lines "${out}")
+
+set(inputs)
+foreach(line IN LISTS lines)
+  string(JSON input ERROR_VARIABLE json_error GET "${line}" input)
+  if(json_error)
+    message(FATAL_ERROR "stdout line is not a JSON object: ${line}\n${json_error}")
+  endif()
+
+  string(JSON result GET "${line}" result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${input} has result ${result}")
+  endif()
+
+  list(APPEND inputs ${input})
+endforeach()
+
+list(SORT inputs)
+if(NOT inputs STREQUAL "../first/a.rco;../second/b.rco")
+  message(FATAL_ERROR "expected one line per input, got: ${inputs}")
+endif()
@@ -0,0 +1,51 @@
+# Helpers for the script tests, which get RCO_DECOMPILER and WORK_DIR from ctest
+
+# Runs RcoDecompiler in dir and fails the test unless it exits with 0
+function(run_checked dir)
+  execute_process(COMMAND ${RCO_DECOMPILER} ${ARGN}
+    WORKING_DIRECTORY ${dir}
+    RESULT_VARIABLE res
+    OUTPUT_VARIABLE out
+    ERROR_VARIABLE out)
+  if(NOT res EQUAL 0)
+    message(FATAL_ERROR "RcoDecompiler ${ARGN} failed (${res}):\n${out}")
+  endif()
+endfunction()
+
+# Compiles ${WORK_DIR}/<name>/plugin.rco with four textures: a and b stored,
+# c and d compressed, so both the plain writers and inflate-to-file are used
+function(make_input name a b c d)
+  set(dir ${WORK_DIR}/${name})
+  file(WRITE ${dir}/plugin/texture/a.png "${a}")
+  file(WRITE ${dir}/plugin/texture/b.png "${b}")
+  file(WRITE ${dir}/plugin/texture/c.gim "${c}")
+  file(WRITE ${dir}/plugin/texture/d.gim "${d}")
+  file(WRITE ${dir}/plugin/plugin.xml
+"<?xml version=\"1.0\" encoding=\"utf-8\"?>
+<resource version=\"1\">
+  <texturetable>
+    <texture id=\"0x10000000\" type=\"texture/png\" src=\"texture/a.png\" />
+    <texture id=\"0x10000001\" type=\"texture/png\" src=\"texture/b.png\" />
+    <texture id=\"0x10000002\" type=\"texture/gim\" src=\"texture/c.gim\" compress=\"on\" origsize=\"0\" />
+    <texture id=\"0x10000003\" type=\"texture/gim\" src=\"texture/d.gim\" compress=\"on\" origsize=\"0\" />
+  </texturetable>
+</resource>
+")
+  run_checked(${dir} --compile plugin/plugin.xml plugin.rco)
+endfunction()
+
+# Fails unless the four textures under <out_dir>/plugin hold a, b, c and d
+function(check_textures out_dir a b c d)
+  set(names texture_0x10000000.png texture_0x10000001.png texture_0x10000002.gim texture_0x10000003.gim)
+  set(expected_list "${a}" "${b}" "${c}" "${d}")
+
+  foreach(i RANGE 3)
+    list(GET names ${i} name)
+    list(GET expected_list ${i} expected)
+
+    file(READ ${out_dir}/plugin/texture/${name} actual)
+    if(NOT actual STREQUAL expected)
+      message(FATAL_ERROR "${name} is \"${actual}\", expected \"${expected}\"")
+    endif()
+  endforeach()
+endfunction()